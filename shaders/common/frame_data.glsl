@@ -0,0 +1,10 @@
+// Per frame data written once by the engine, see FrameData in frame_data.hpp
+layout (std140) uniform FrameData {
+    mat4 projection;
+    mat4 view;
+    mat4 viewProjection;
+    vec4 cameraPos;
+    vec4 viewport;
+    float time;
+    float deltaTime;
+};
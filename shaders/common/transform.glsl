@@ -0,0 +1,6 @@
+#include "frame_data.glsl"
+
+// Transformation of the object being drawn
+uniform mat4 model;
+// Inverse transpose of mat3(model), computed once per object by the engine
+uniform mat3 normalMatrix;
@@ -5,11 +5,9 @@ layout (location = 1) in vec2 aTexCoord;
 
 out vec2 TexCoord;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+#include "common/transform.glsl"
 
 void main() {
-    gl_Position = projection * view * model * vec4(aPos, 1.0f);
+    gl_Position = viewProjection * model * vec4(aPos, 1.0f);
     TexCoord = vec2(aTexCoord.x, 1.0 - aTexCoord.y);
 }
\ No newline at end of file
@@ -2,8 +2,21 @@
 out vec4 FragColor;
 
 struct Material {
+#ifdef TEXTURE_ATLAS
+    // Every map is a region of a layer of the same texture array, offset in xy and scale in zw
+    sampler2DArray atlas;
+    vec4 diffuseRect;
+    float diffuseLayer;
+#ifdef SPECULAR_MAP
+    vec4 specularRect;
+    float specularLayer;
+#endif
+#else
     sampler2D diffuse;
-    sampler2D specular;    
+#ifdef SPECULAR_MAP
+    sampler2D specular;
+#endif
+#endif
     float shininess;
 }; 
 
@@ -19,26 +32,53 @@ in vec3 FragPos;
 in vec3 Normal;  
 in vec2 TexCoords;
   
-uniform vec3 viewPos;
+#include "common/frame_data.glsl"
+
 uniform Material material;
 uniform Light light;
 
+vec3 sampleDiffuse()
+{
+#ifdef TEXTURE_ATLAS
+    return texture(material.atlas, vec3(TexCoords * material.diffuseRect.zw + material.diffuseRect.xy, material.diffuseLayer)).rgb;
+#else
+    return texture(material.diffuse, TexCoords).rgb;
+#endif
+}
+
+#ifdef SPECULAR_MAP
+vec3 sampleSpecular()
+{
+#ifdef TEXTURE_ATLAS
+    return texture(material.atlas, vec3(TexCoords * material.specularRect.zw + material.specularRect.xy, material.specularLayer)).rgb;
+#else
+    return texture(material.specular, TexCoords).rgb;
+#endif
+}
+#endif
+
 void main()
 {
+    vec3 albedo = sampleDiffuse();
+
     // ambient
-    vec3 ambient = light.ambient * texture(material.diffuse, TexCoords).rgb;
+    vec3 ambient = light.ambient * albedo;
   	
     // diffuse 
     vec3 norm = normalize(Normal);
     vec3 lightDir = normalize(light.position - FragPos);
     float diff = max(dot(norm, lightDir), 0.0);
-    vec3 diffuse = light.diffuse * diff * texture(material.diffuse, TexCoords).rgb;  
+    vec3 diffuse = light.diffuse * diff * albedo;  
     
     // specular
-    vec3 viewDir = normalize(viewPos - FragPos);
+    vec3 viewDir = normalize(cameraPos.xyz - FragPos);
     vec3 reflectDir = reflect(-lightDir, norm);  
     float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
-    vec3 specular = light.specular * spec * texture(material.specular, TexCoords).rgb;  
+#ifdef SPECULAR_MAP
+    vec3 specular = light.specular * spec * sampleSpecular();
+#else
+    vec3 specular = light.specular * spec;
+#endif
         
     vec3 result = ambient + diffuse + specular;
     FragColor = vec4(result, 1.0);
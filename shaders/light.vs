@@ -1,21 +1,42 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;
+#ifdef COMPACT_VERTEX
+// Octahedral encoding, see VertexQuantization
+layout (location = 1) in vec2 aNormal;
+#else
 layout (location = 1) in vec3 aNormal;
+#endif
 layout (location = 2) in vec2 aTexCoords;
 
 out vec3 FragPos;
 out vec3 Normal;
 out vec2 TexCoords;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+#include "common/transform.glsl"
+
+#ifdef COMPACT_VERTEX
+// Offset in xy and scale in zw of the quantized texture coordinates, positions are decoded by the model matrix
+uniform vec4 texCoordTransform;
+
+vec3 octahedralDecode(vec2 encoded)
+{
+    vec3 normal = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    float fold = max(-normal.z, 0.0);
+    normal.xy += vec2(normal.x >= 0.0 ? -fold : fold, normal.y >= 0.0 ? -fold : fold);
+    return normalize(normal);
+}
+#endif
 
 void main()
 {
     FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = mat3(transpose(inverse(model))) * aNormal;  
+#ifdef COMPACT_VERTEX
+    Normal = normalMatrix * octahedralDecode(aNormal);
+    TexCoords = texCoordTransform.xy + texCoordTransform.zw * aTexCoords;
+#else
+    Normal = normalMatrix * aNormal;
     TexCoords = aTexCoords;
+#endif
     
-    gl_Position = projection * view * vec4(FragPos, 1.0);
-}
\ No newline at end of file
+    gl_Position = viewProjection * vec4(FragPos, 1.0);
+}
@@ -103,3 +103,14 @@ void Camera::updateVectors() {
 float Camera::getZoom() {
 	return this->zoom;
 }
+
+float Camera::projectedSize(const glm::vec3& center, float radius, float viewportHeight) {
+	float distance = glm::length(center - cameraPos);
+	if (distance <= radius) {
+		return viewportHeight;
+	}
+
+	// Same vertical field of view as the projection matrix, the sphere is seen under its tangents
+	float tangent = std::tan(glm::radians(zoom) * 0.5f);
+	return std::min(radius / (std::sqrt(distance * distance - radius * radius) * tangent) * viewportHeight, viewportHeight);
+}
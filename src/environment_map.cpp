@@ -0,0 +1,371 @@
+#include "headers/environment_map.hpp"
+#include "headers/texture.hpp"
+#include "headers/texture_disk_cache.hpp"
+#include "headers/mip_generator.hpp"
+#include "headers/mapped_file.hpp"
+#include "headers/half_float.hpp"
+#include "headers/thread_pool.hpp"
+#include "headers/logger.hpp"
+
+#include <stb/stb_image.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <future>
+#include <vector>
+
+namespace {
+    constexpr float PI = 3.14159265358979f;
+    // Part of the cache keys, to be changed with the precompute
+    constexpr const char* BAKE_VERSION = "environment-v1";
+    // Faces of the smallest specular level, smaller ones would only blur the roughest lobe further
+    constexpr int SMALLEST_FACE = 4;
+    // Rows of the source or of a face handled by a job, large enough to keep the queue overhead negligible
+    constexpr int ROWS_PER_JOB = 8;
+
+    /**
+     * @brief A direction of a prefiltering lobe around +Z, with its weight and the source level to sample
+     */
+    struct LobeSample {
+        glm::vec3 direction;
+        float weight;
+        float lod;
+    };
+
+    float radicalInverse(uint32_t bits) {
+        bits = (bits << 16u) | (bits >> 16u);
+        bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+        bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+        bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+        bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+        return static_cast<float>(bits) * 2.3283064365386963e-10f;
+    }
+
+    /**
+     * @brief Direction through the center of a texel of a face, faces in the order of GL_TEXTURE_CUBE_MAP_POSITIVE_X
+     */
+    glm::vec3 faceDirection(int face, int x, int y, int size) {
+        float u = 2.0f * (x + 0.5f) / size - 1.0f;
+        float v = 2.0f * (y + 0.5f) / size - 1.0f;
+        switch (face) {
+        case 0: return glm::normalize(glm::vec3(1.0f, -v, -u));
+        case 1: return glm::normalize(glm::vec3(-1.0f, -v, u));
+        case 2: return glm::normalize(glm::vec3(u, 1.0f, v));
+        case 3: return glm::normalize(glm::vec3(u, -1.0f, -v));
+        case 4: return glm::normalize(glm::vec3(u, -v, 1.0f));
+        default: return glm::normalize(glm::vec3(-u, -v, -1.0f));
+        }
+    }
+
+    /**
+     * @brief Bilinear fetch of a level of the equirectangular source, wrapping around horizontally
+     */
+    glm::vec3 fetch(const TextureImage& source, int level, float u, float v) {
+        const TextureLevel& info = source.levels[level];
+        const float* texels = reinterpret_cast<const float*>(source.data() + info.offset);
+
+        float x = u * info.width - 0.5f;
+        float y = std::clamp(v * info.height - 0.5f, 0.0f, static_cast<float>(info.height - 1));
+        int x0 = static_cast<int>(std::floor(x));
+        int y0 = static_cast<int>(y);
+        float fx = x - x0, fy = y - y0;
+        int x1 = x0 + 1;
+        int y1 = std::min(y0 + 1, info.height - 1);
+        x0 = ((x0 % info.width) + info.width) % info.width;
+        x1 = x1 % info.width;
+
+        auto texel = [&](int tx, int ty) {
+            const float* t = texels + (static_cast<size_t>(ty) * info.width + tx) * 3;
+            return glm::vec3(t[0], t[1], t[2]);
+        };
+        glm::vec3 top = glm::mix(texel(x0, y0), texel(x1, y0), fx);
+        glm::vec3 bottom = glm::mix(texel(x0, y1), texel(x1, y1), fx);
+        return glm::mix(top, bottom, fy);
+    }
+
+    /**
+     * @brief Trilinear sample of the source in a direction, the first row of the source is the top of the sky
+     */
+    glm::vec3 sample(const TextureImage& source, const glm::vec3& direction, float lod) {
+        float u = std::atan2(direction.z, direction.x) / (2.0f * PI) + 0.5f;
+        float v = std::acos(std::clamp(direction.y, -1.0f, 1.0f)) / PI;
+
+        float level = std::clamp(lod, 0.0f, static_cast<float>(source.levels.size() - 1));
+        int lower = static_cast<int>(level);
+        int upper = std::min(lower + 1, static_cast<int>(source.levels.size() - 1));
+        glm::vec3 color = fetch(source, lower, u, v);
+        if (upper != lower && level > lower) {
+            color = glm::mix(color, fetch(source, upper, u, v), level - lower);
+        }
+        return color;
+    }
+
+    /**
+     * @brief The 9 real spherical harmonics of the first 3 bands
+     */
+    std::array<float, 9> shBasis(const glm::vec3& d) {
+        return { 0.282095f,
+                 0.488603f * d.y, 0.488603f * d.z, 0.488603f * d.x,
+                 1.092548f * d.x * d.y, 1.092548f * d.y * d.z, 0.315392f * (3.0f * d.z * d.z - 1.0f),
+                 1.092548f * d.x * d.z, 0.546274f * (d.x * d.x - d.y * d.y) };
+    }
+
+    /**
+     * @brief Directions of the GGX lobe of a roughness for N = V = +Z, importance sampled on the Hammersley set
+     *
+     * @param sourceSolidAngle The solid angle of a texel of the largest source level,
+     * samples covering a larger solid angle read a smaller level so the lobe isn't undersampled
+     */
+    std::vector<LobeSample> buildLobe(float roughness, int samples, float sourceSolidAngle, float faceSolidAngle) {
+        if (roughness == 0.0f) {
+            // A mirror only needs the source filtered down to the texels of the face
+            return { { glm::vec3(0.0f, 0.0f, 1.0f), 1.0f, std::max(0.0f, 0.5f * std::log2(faceSolidAngle / sourceSolidAngle)) } };
+        }
+
+        float alpha = roughness * roughness;
+        float alpha2 = alpha * alpha;
+        std::vector<LobeSample> lobe;
+        float total = 0.0f;
+        for (int i = 0; i < samples; i++) {
+            float phi = 2.0f * PI * (i + 0.5f) / samples;
+            float xi = radicalInverse(static_cast<uint32_t>(i));
+            float cosTheta = std::sqrt((1.0f - xi) / (1.0f + (alpha2 - 1.0f) * xi));
+            float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
+            glm::vec3 half(sinTheta * std::cos(phi), sinTheta * std::sin(phi), cosTheta);
+            glm::vec3 light = 2.0f * half.z * half - glm::vec3(0.0f, 0.0f, 1.0f);
+            if (light.z <= 0.0f) {
+                continue;
+            }
+
+            // With N = V the pdf of the reflected direction is D / 4
+            float denominator = (alpha2 - 1.0f) * cosTheta * cosTheta + 1.0f;
+            float pdf = alpha2 / (PI * denominator * denominator) / 4.0f;
+            float sampleSolidAngle = 1.0f / (samples * pdf);
+            float lod = std::max(0.0f, 0.5f * std::log2(sampleSolidAngle / sourceSolidAngle) + 1.0f);
+
+            lobe.push_back({ light, light.z, lod });
+            total += light.z;
+        }
+        for (LobeSample& s : lobe) {
+            s.weight /= total;
+        }
+        return lobe;
+    }
+}
+
+EnvironmentMap::~EnvironmentMap() {
+    if (m_specular != 0) {
+        Texture::unbind(m_specular);
+        glDeleteTextures(1, &m_specular);
+    }
+}
+
+bool EnvironmentMap::bake(const std::string& filename, const Options& options, Baked& baked) {
+    MappedFile file(filename);
+    if (!file.isOpen()) {
+        return false;
+    }
+
+    std::string description = std::string(BAKE_VERSION) + ";size=" + std::to_string(options.size) + ";samples=" + std::to_string(options.samples);
+    uint64_t specularKey = TextureDiskCache::key(file.data(), file.size(), description + ";specular");
+    uint64_t irradianceKey = TextureDiskCache::key(file.data(), file.size(), description + ";irradiance");
+
+    TextureImage irradiance;
+    if (TextureDiskCache::load(specularKey, baked.specular) && TextureDiskCache::load(irradianceKey, irradiance)
+        && irradiance.byteSize() == sizeof(baked.irradiance)) {
+        std::memcpy(baked.irradiance.data(), irradiance.data(), sizeof(baked.irradiance));
+        return true;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    // Linear radiance, LDR files are converted by stb
+    TextureImage source;
+    stbi_set_flip_vertically_on_load_thread(false);
+    float* pixels = stbi_loadf_from_memory(file.data(), static_cast<int>(file.size()), &source.width, &source.height, &source.channels, 3);
+    if (pixels == nullptr) {
+        return false;
+    }
+    source.channels = 3;
+    source.format = GL_RGB;
+    source.internalFormat = GL_RGB;
+    source.type = GL_FLOAT;
+    source.compressed = false;
+    size_t size = static_cast<size_t>(source.width) * source.height * 3 * sizeof(float);
+    source.pixels.assign(reinterpret_cast<unsigned char*>(pixels), reinterpret_cast<unsigned char*>(pixels) + size);
+    source.levels = { { 0, size, source.width, source.height } };
+    stbi_image_free(pixels);
+
+    // Smaller levels of the source are read by the wide lobes instead of averaging many samples
+    MipGenerator::Options mips;
+    mips.filter = MipGenerator::Filter::BOX;
+    MipGenerator::generate(source, mips);
+
+    ThreadPool& pool = ThreadPool::loaders();
+
+    // Irradiance, every texel of the source weighted by its solid angle, summed per band of rows
+    std::vector<std::future<std::array<glm::dvec3, 9>>> sums;
+    for (int first = 0; first < source.height; first += ROWS_PER_JOB) {
+        int last = std::min(first + ROWS_PER_JOB, source.height);
+        sums.push_back(pool.submit([&source, first, last]() {
+            std::array<glm::dvec3, 9> sum{};
+            const float* texels = reinterpret_cast<const float*>(source.data());
+            for (int y = first; y < last; y++) {
+                float theta = PI * (y + 0.5f) / source.height;
+                float solidAngle = (2.0f * PI / source.width) * (PI / source.height) * std::sin(theta);
+                for (int x = 0; x < source.width; x++) {
+                    float phi = 2.0f * PI * ((x + 0.5f) / source.width - 0.5f);
+                    glm::vec3 direction(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+                    const float* t = texels + (static_cast<size_t>(y) * source.width + x) * 3;
+                    glm::dvec3 radiance = glm::dvec3(t[0], t[1], t[2]) * static_cast<double>(solidAngle);
+                    std::array<float, 9> basis = shBasis(direction);
+                    for (int i = 0; i < 9; i++) {
+                        sum[i] += radiance * static_cast<double>(basis[i]);
+                    }
+                }
+            }
+            return sum;
+        }));
+    }
+
+    // Specular, one job per band of rows of a face of a level, each writes its own half floats
+    int levels = std::max(1, static_cast<int>(std::log2(options.size / SMALLEST_FACE)) + 1);
+    baked.specular = TextureImage{};
+    baked.specular.width = options.size;
+    baked.specular.height = options.size;
+    baked.specular.channels = 3;
+    baked.specular.format = GL_RGB;
+    baked.specular.internalFormat = GL_RGB16F;
+    baked.specular.type = GL_HALF_FLOAT;
+    baked.specular.compressed = false;
+    size_t offset = 0;
+    for (int level = 0; level < levels; level++) {
+        int faceSize = std::max(1, options.size >> level);
+        size_t faceBytes = static_cast<size_t>(faceSize) * faceSize * 3 * sizeof(uint16_t);
+        for (int face = 0; face < 6; face++) {
+            baked.specular.levels.push_back({ offset, faceBytes, faceSize, faceSize });
+            offset += faceBytes;
+        }
+    }
+    baked.specular.pixels.resize(offset);
+
+    float sourceSolidAngle = 4.0f * PI / (static_cast<float>(source.width) * source.height);
+    std::vector<std::vector<LobeSample>> lobes;
+    for (int level = 0; level < levels; level++) {
+        int faceSize = std::max(1, options.size >> level);
+        float roughness = levels > 1 ? static_cast<float>(level) / (levels - 1) : 0.0f;
+        lobes.push_back(buildLobe(roughness, options.samples, sourceSolidAngle, 4.0f * PI / (6.0f * faceSize * faceSize)));
+    }
+
+    std::vector<std::future<void>> faces;
+    for (int level = 0; level < levels; level++) {
+        int faceSize = std::max(1, options.size >> level);
+        for (int face = 0; face < 6; face++) {
+            for (int first = 0; first < faceSize; first += ROWS_PER_JOB) {
+                int last = std::min(first + ROWS_PER_JOB, faceSize);
+                faces.push_back(pool.submit([&source, &baked, &lobes, level, face, faceSize, first, last]() {
+                    const std::vector<LobeSample>& lobe = lobes[level];
+                    const TextureLevel& target = baked.specular.levels[level * 6 + face];
+                    uint16_t* halves = reinterpret_cast<uint16_t*>(baked.specular.pixels.data() + target.offset);
+                    std::vector<float> row(static_cast<size_t>(faceSize) * 3);
+
+                    for (int y = first; y < last; y++) {
+                        for (int x = 0; x < faceSize; x++) {
+                            glm::vec3 normal = faceDirection(face, x, y, faceSize);
+                            glm::vec3 up = std::abs(normal.z) < 0.999f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+                            glm::vec3 tangent = glm::normalize(glm::cross(up, normal));
+                            glm::vec3 bitangent = glm::cross(normal, tangent);
+
+                            glm::vec3 color(0.0f);
+                            for (const LobeSample& s : lobe) {
+                                glm::vec3 direction = tangent * s.direction.x + bitangent * s.direction.y + normal * s.direction.z;
+                                color += sample(source, direction, s.lod) * s.weight;
+                            }
+                            row[x * 3 + 0] = color.r;
+                            row[x * 3 + 1] = color.g;
+                            row[x * 3 + 2] = color.b;
+                        }
+                        HalfFloat::fromFloats(row.data(), halves + static_cast<size_t>(y) * faceSize * 3, row.size());
+                    }
+                }));
+            }
+        }
+    }
+
+    std::array<glm::dvec3, 9> total{};
+    for (auto& sum : sums) {
+        std::array<glm::dvec3, 9> part = sum.get();
+        for (int i = 0; i < 9; i++) {
+            total[i] += part[i];
+        }
+    }
+    for (auto& face : faces) {
+        face.get();
+    }
+
+    // Convolution with the clamped cosine lobe, per band
+    const float bands[9] = { PI, 2.0f * PI / 3.0f, 2.0f * PI / 3.0f, 2.0f * PI / 3.0f, PI / 4.0f, PI / 4.0f, PI / 4.0f, PI / 4.0f, PI / 4.0f };
+    for (int i = 0; i < 9; i++) {
+        baked.irradiance[i] = glm::vec3(total[i]) * bands[i];
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    logger.log("Baked environment " + filename + " in " + std::to_string(elapsed.count()) + " ms on " + std::to_string(pool.size()) + " threads");
+
+    irradiance = TextureImage{};
+    irradiance.width = 9;
+    irradiance.height = 1;
+    irradiance.channels = 3;
+    irradiance.format = GL_RGB;
+    irradiance.internalFormat = GL_RGB32F;
+    irradiance.type = GL_FLOAT;
+    irradiance.compressed = false;
+    irradiance.pixels.resize(sizeof(baked.irradiance));
+    std::memcpy(irradiance.pixels.data(), baked.irradiance.data(), sizeof(baked.irradiance));
+    irradiance.levels = { { 0, irradiance.pixels.size(), 9, 1 } };
+    TextureDiskCache::store(specularKey, baked.specular);
+    TextureDiskCache::store(irradianceKey, irradiance);
+    return true;
+}
+
+bool EnvironmentMap::load(const std::string& filename, const Options& options) {
+    Baked baked;
+    if (!bake(filename, options, baked)) {
+        logger.error("Failed to load environment: " + filename);
+        return false;
+    }
+
+    if (m_specular != 0) {
+        Texture::unbind(m_specular);
+        glDeleteTextures(1, &m_specular);
+    }
+    m_irradiance = baked.irradiance;
+    m_levels = static_cast<GLint>(baked.specular.levels.size() / 6);
+
+    glGenTextures(1, &m_specular);
+    Texture::bind(0, GL_TEXTURE_CUBE_MAP, m_specular);
+    glTexStorage2D(GL_TEXTURE_CUBE_MAP, m_levels, GL_RGB16F, baked.specular.width, baked.specular.height);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (size_t i = 0; i < baked.specular.levels.size(); i++) {
+        const TextureLevel& level = baked.specular.levels[i];
+        glTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + static_cast<GLenum>(i % 6), static_cast<GLint>(i / 6), 0, 0, level.width, level.height,
+                        GL_RGB, GL_HALF_FLOAT, baked.specular.data() + level.offset);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, m_levels - 1);
+    // Prefiltered levels are blurry enough for the seams between faces to show without it
+    glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+    return true;
+}
+
+void EnvironmentMap::bind(GLuint unit) const {
+    Texture::bind(unit, GL_TEXTURE_CUBE_MAP, m_specular);
+}
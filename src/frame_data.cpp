@@ -0,0 +1,20 @@
+#include "headers/frame_data.hpp"
+
+FrameDataBuffer::FrameDataBuffer() {
+    glGenBuffers(1, &m_ID);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_ID);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameData), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    glBindBufferBase(GL_UNIFORM_BUFFER, FrameData::BINDING, m_ID);
+}
+
+FrameDataBuffer::~FrameDataBuffer() {
+    glDeleteBuffers(1, &m_ID);
+}
+
+void FrameDataBuffer::update(const FrameData &data) {
+    glBindBuffer(GL_UNIFORM_BUFFER, m_ID);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameData), &data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
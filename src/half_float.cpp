@@ -0,0 +1,124 @@
+#include "headers/half_float.hpp"
+
+#include <cstring>
+
+#if defined(__F16C__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define HALF_FLOAT_SSE2
+#endif
+
+namespace {
+    // Bit patterns of 32 bits floats
+    constexpr uint32_t SIGN = 0x80000000u;
+    constexpr uint32_t INFINITY_32 = 0x7f800000u;
+    constexpr uint32_t INFINITY_16 = 0x7c00u;
+    constexpr uint32_t NAN_BIT_16 = 0x200u;
+    // Smallest float rounded to the half infinity, 65520
+    constexpr uint32_t HALF_OVERFLOW = (127 + 16) << 23;
+    // Smallest float giving a normal half, 2^-14
+    constexpr uint32_t HALF_MIN_NORMAL = (127 - 14) << 23;
+    // Adding this float aligns the mantissa of a subnormal half, the FPU does the rounding
+    constexpr uint32_t SUBNORMAL_MAGIC = ((127 - 15) + (23 - 10) + 1) << 23;
+    // Rebias the exponent and round to nearest, the odd bit is added separately to round ties to even
+    constexpr uint32_t NORMAL_BIAS = 0xfff - ((127 - 15) << 23);
+
+    uint32_t bitsOf(float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    float floatOf(uint32_t bits) {
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+}
+
+uint16_t HalfFloat::fromFloat(float value) {
+    uint32_t bits = bitsOf(value);
+    uint32_t sign = bits & SIGN;
+    uint32_t magnitude = bits ^ sign;
+
+    uint32_t half;
+    if (magnitude >= HALF_OVERFLOW) {
+        half = magnitude > INFINITY_32 ? INFINITY_16 | NAN_BIT_16 : INFINITY_16;
+    } else if (magnitude < HALF_MIN_NORMAL) {
+        half = bitsOf(floatOf(magnitude) + floatOf(SUBNORMAL_MAGIC)) - SUBNORMAL_MAGIC;
+    } else {
+        uint32_t odd = (magnitude >> 13) & 1;
+        half = (magnitude + NORMAL_BIAS + odd) >> 13;
+    }
+    return static_cast<uint16_t>(half | (sign >> 16));
+}
+
+float HalfFloat::toFloat(uint16_t value) {
+    uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+    uint32_t exponent = (value >> 10) & 0x1f;
+    uint32_t mantissa = value & 0x3ff;
+
+    if (exponent == 0x1f) {
+        return floatOf(sign | INFINITY_32 | (mantissa << 13));
+    }
+    if (exponent == 0) {
+        // Subnormals are exact in single precision, 2^-24 per step
+        float magnitude = static_cast<float>(mantissa) * floatOf((127 - 24) << 23);
+        return floatOf(sign | bitsOf(magnitude));
+    }
+    return floatOf(sign | ((exponent + 127 - 15) << 23) | (mantissa << 13));
+}
+
+void HalfFloat::fromFloats(const float* source, uint16_t* destination, size_t count) {
+    size_t i = 0;
+#if defined(__F16C__)
+    for (; i + 8 <= count; i += 8) {
+        __m128i halves = _mm256_cvtps_ph(_mm256_loadu_ps(source + i), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), halves);
+    }
+#elif defined(HALF_FLOAT_SSE2)
+    // Both branches of the scalar conversion are computed and selected with masks
+    const __m128i signMask = _mm_set1_epi32(static_cast<int>(SIGN));
+    const __m128i infinity32 = _mm_set1_epi32(static_cast<int>(INFINITY_32));
+    const __m128i infinity16 = _mm_set1_epi32(static_cast<int>(INFINITY_16));
+    const __m128i nanBit = _mm_set1_epi32(static_cast<int>(NAN_BIT_16));
+    const __m128i overflow = _mm_set1_epi32(static_cast<int>(HALF_OVERFLOW));
+    const __m128i minNormal = _mm_set1_epi32(static_cast<int>(HALF_MIN_NORMAL));
+    const __m128i subnormalMagic = _mm_set1_epi32(static_cast<int>(SUBNORMAL_MAGIC));
+    const __m128i normalBias = _mm_set1_epi32(static_cast<int>(NORMAL_BIAS));
+
+    auto convert = [&](__m128 values) {
+        __m128i bits = _mm_castps_si128(values);
+        __m128i sign = _mm_and_si128(bits, signMask);
+        __m128i magnitude = _mm_xor_si128(bits, sign);
+
+        __m128i isNan = _mm_cmpgt_epi32(magnitude, infinity32);
+        __m128i isRegular = _mm_cmpgt_epi32(overflow, magnitude);
+        __m128i isSubnormal = _mm_cmpgt_epi32(minNormal, magnitude);
+        __m128i special = _mm_or_si128(_mm_and_si128(isNan, nanBit), infinity16);
+
+        __m128 subnormalSum = _mm_add_ps(_mm_castsi128_ps(magnitude), _mm_castsi128_ps(subnormalMagic));
+        __m128i subnormal = _mm_sub_epi32(_mm_castps_si128(subnormalSum), subnormalMagic);
+
+        // Arithmetic shift of the odd bit gives -1 when it's set, subtracting it adds one
+        __m128i odd = _mm_srai_epi32(_mm_slli_epi32(magnitude, 31 - 13), 31);
+        __m128i normal = _mm_srli_epi32(_mm_sub_epi32(_mm_add_epi32(magnitude, normalBias), odd), 13);
+
+        __m128i finite = _mm_or_si128(_mm_and_si128(isSubnormal, subnormal), _mm_andnot_si128(isSubnormal, normal));
+        __m128i half = _mm_or_si128(_mm_and_si128(isRegular, finite), _mm_andnot_si128(isRegular, special));
+        half = _mm_or_si128(half, _mm_srli_epi32(sign, 16));
+        // Sign extended so the saturating pack keeps the 16 bits as they are
+        return _mm_srai_epi32(_mm_slli_epi32(half, 16), 16);
+    };
+
+    for (; i + 8 <= count; i += 8) {
+        __m128i low = convert(_mm_loadu_ps(source + i));
+        __m128i high = convert(_mm_loadu_ps(source + i + 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), _mm_packs_epi32(low, high));
+    }
+#endif
+    for (; i < count; i++) {
+        destination[i] = fromFloat(source[i]);
+    }
+}
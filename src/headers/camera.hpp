@@ -52,6 +52,16 @@ public:
 
 	float getZoom();
 
+	/**
+	 * @brief Estimate the size of an object on the screen from its bounding sphere
+	 *
+	 * @param center The center of the sphere in world space
+	 * @param radius The radius of the sphere
+	 * @param viewportHeight The height of the viewport in pixels
+	 * @return float The diameter of the sphere on the screen in pixels, the viewport height when the camera is inside
+	 */
+	float projectedSize(const glm::vec3 &center, float radius, float viewportHeight);
+
 	/**
 	 * @return the LookAt (or view) matrix
 	 */
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+
+/**
+ * @brief Directory of the files written by the cookers, next to the other caches and out of the source tree
+ */
+inline const std::filesystem::path COOKED_DIRECTORY = "cache/cooked";
+
+/**
+ * @brief Get where a cooker writes the file of a source asset, the path of the source under @ref COOKED_DIRECTORY with another extension
+ *
+ * Relative sources are relative to the working directory, like every asset path, the cookers run from the same directory as the engine.
+ * Sources outside of it keep their absolute path under the directory.
+ */
+inline std::string cookedPath(const std::string &source, const char *extension) {
+    std::filesystem::path path = std::filesystem::path(source).lexically_normal();
+    if (path.is_relative() && !path.empty() && *path.begin() == "..") {
+        path = std::filesystem::absolute(path).lexically_normal();
+    }
+    return (COOKED_DIRECTORY / path.relative_path()).replace_extension(extension).generic_string();
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * @brief What texture-cook records in the key/value data of its KTX2 files,
+ * files cooked by another version of the cooker or with other options are out of date like older ones
+ *
+ * Shared by the cooker and the runtime, the cooker doesn't link the texture loading code.
+ */
+class CookedTexture
+{
+public:
+    // Bump when the cooked output changes, e.g. the mip filter or the encoder
+    static constexpr const char *VERSION = "2";
+
+    // Keys are sorted as KTX2 requires, before KTXorientation
+    static constexpr const char *FORMAT_KEY = "AEcookFormat";
+    static constexpr const char *MIPS_KEY = "AEcookMips";
+    static constexpr const char *VERSION_KEY = "AEcookVersion";
+
+    /**
+     * @brief Read the key/value data of a KTX2 file, nothing else of the file is read
+     *
+     * @return Empty if the file can't be read or isn't a KTX2 file
+     */
+    static std::map<std::string, std::string> readValues(const std::string &filename) {
+        std::map<std::string, std::string> values;
+        std::ifstream file(filename, std::ios::binary);
+        unsigned char header[80];
+        if (!file.read(reinterpret_cast<char *>(header), sizeof(header)) || std::memcmp(header, IDENTIFIER, sizeof(IDENTIFIER)) != 0) {
+            return values;
+        }
+
+        uint32_t offset, length;
+        std::memcpy(&offset, header + 56, sizeof(offset));
+        std::memcpy(&length, header + 60, sizeof(length));
+        // The lengths come from the file, a corrupt one can't claim more bytes than the file has
+        std::error_code error;
+        uintmax_t size = std::filesystem::file_size(filename, error);
+        if (error || offset > size || length > size - offset) {
+            return values;
+        }
+        std::vector<char> data(length);
+        if (!file.seekg(offset) || !file.read(data.data(), length)) {
+            return values;
+        }
+
+        // Each entry is its length, the key and the value separated by a null, padded to 4 bytes
+        for (size_t position = 0; position + sizeof(uint32_t) <= length;) {
+            uint32_t size;
+            std::memcpy(&size, data.data() + position, sizeof(size));
+            position += sizeof(size);
+            if (size > length - position) {
+                break;
+            }
+            std::string entry(data.data() + position, size);
+            size_t separator = entry.find('\0');
+            if (separator != std::string::npos) {
+                std::string value = entry.substr(separator + 1);
+                if (!value.empty() && value.back() == '\0') {
+                    value.pop_back();
+                }
+                values[entry.substr(0, separator)] = value;
+            }
+            position += (size + 3) / 4 * 4;
+        }
+        return values;
+    }
+
+    /**
+     * @brief Returns true if the cooked file is at least as recent as its source and was cooked by this version with the options
+     *
+     * @param mips The mip options, see MipGenerator::describe
+     * @param format The format asked to the cooker, empty to accept any
+     */
+    static bool isUpToDate(const std::string &source, const std::string &cooked, const std::string &mips, const std::string &format = "") {
+        std::error_code error;
+        auto cookedTime = std::filesystem::last_write_time(cooked, error);
+        if (error) {
+            return false;
+        }
+        auto sourceTime = std::filesystem::last_write_time(source, error);
+        if (error || cookedTime < sourceTime) {
+            return false;
+        }
+
+        std::map<std::string, std::string> values = readValues(cooked);
+        return values[VERSION_KEY] == VERSION && values[MIPS_KEY] == mips && (format.empty() || values[FORMAT_KEY] == format);
+    }
+
+private:
+    static constexpr unsigned char IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+};
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "glad/glad.h"
+#include <glm/glm.hpp>
+
+#include "texture_image.hpp"
+
+#include <array>
+#include <string>
+
+/**
+ * @brief Image based lighting precomputed on the CPU from an equirectangular HDR environment
+ *
+ * The diffuse irradiance is projected on the 9 spherical harmonics of the first 3 bands,
+ * the specular part is a cubemap whose levels are the environment prefiltered with GGX lobes of increasing roughness.
+ * The work is split into jobs on the loader threads and both results are stored in the @ref TextureDiskCache,
+ * keyed by the bytes of the HDR file, so later runs only read them back.
+ */
+class EnvironmentMap
+{
+public:
+    struct Options {
+        // Size of the faces of the largest specular level
+        int size = 128;
+        // GGX samples per texel of the rough levels
+        int samples = 256;
+    };
+
+    /**
+     * @brief Result of @ref bake, no OpenGL involved
+     */
+    struct Baked {
+        // Irradiance coefficients, already convolved with the cosine lobe, see @ref getIrradiance
+        std::array<glm::vec3, 9> irradiance{};
+        // GL_HALF_FLOAT RGB faces, the 6 faces of a level follow each other from the largest level down
+        TextureImage specular;
+    };
+
+    EnvironmentMap() = default;
+    ~EnvironmentMap();
+
+    EnvironmentMap(const EnvironmentMap &) = delete;
+    EnvironmentMap &operator=(const EnvironmentMap &) = delete;
+
+    /**
+     * @brief Read or precompute the lighting of an environment
+     *
+     * @note Blocks until the jobs on the loader threads are done, must not be called from one of them
+     * @return false if the file can't be decoded
+     */
+    static bool bake(const std::string &filename, const Options &options, Baked &baked);
+
+    /**
+     * @brief Bake an environment and upload its specular cubemap, to be called from the GL thread
+     *
+     * @return false if the file can't be decoded
+     */
+    bool load(const std::string &filename, const Options &options);
+
+    /**
+     * @brief Get the spherical harmonics of the irradiance, in the order (0,0) (1,-1) (1,0) (1,1) (2,-2) (2,-1) (2,0) (2,1) (2,2)
+     *
+     * The irradiance around a normal n is the sum of the coefficients times the basis functions evaluated at n,
+     * a Lambertian surface reflects it times albedo / pi.
+     */
+    const std::array<glm::vec3, 9> &getIrradiance() const {
+        return m_irradiance;
+    }
+
+    GLuint getSpecular() const {
+        return m_specular;
+    }
+
+    /**
+     * @brief Get the number of levels of the specular cubemap, the roughness of a level is level / (levels - 1)
+     */
+    GLint getSpecularLevels() const {
+        return m_levels;
+    }
+
+    /**
+     * @brief Bind the specular cubemap, see Texture::bind
+     */
+    void bind(GLuint unit) const;
+
+private:
+    GLuint m_specular = 0;
+    GLint m_levels = 0;
+    std::array<glm::vec3, 9> m_irradiance{};
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "glad/glad.h"
+#include "glm/glm.hpp"
+
+#include <cstddef>
+
+/**
+ * @brief Per frame data shared by every program through the "FrameData" uniform block
+ *
+ * The layout follows std140 and must match the block declared in the shaders :
+ * @code
+ * layout (std140) uniform FrameData {
+ *     mat4 projection;
+ *     mat4 view;
+ *     mat4 viewProjection;
+ *     vec4 cameraPos;     // xyz = position of the camera
+ *     vec4 viewport;      // xy = size in pixels, zw = 1 / size
+ *     float time;
+ *     float deltaTime;
+ * };
+ * @endcode
+ */
+struct FrameData {
+    glm::mat4 projection;
+    glm::mat4 view;
+    glm::mat4 viewProjection;
+    glm::vec4 cameraPos;
+    glm::vec4 viewport;
+    float time;
+    float deltaTime;
+    float padding[2];
+
+    // Binding point of the uniform block, every Shader binds its "FrameData" block to it after linking
+    static constexpr GLuint BINDING = 0;
+};
+
+static_assert(offsetof(FrameData, view) == 64, "FrameData doesn't follow std140");
+static_assert(offsetof(FrameData, cameraPos) == 192, "FrameData doesn't follow std140");
+static_assert(offsetof(FrameData, time) == 224, "FrameData doesn't follow std140");
+static_assert(sizeof(FrameData) == 240, "FrameData doesn't follow std140");
+
+class FrameDataBuffer
+{
+public:
+    /**
+     * @brief Creates the uniform buffer and binds it to @ref FrameData::BINDING
+     *
+     * @note Needs a current OpenGL context
+     */
+    FrameDataBuffer();
+
+    /**
+     * @brief Delete the uniform buffer
+     */
+    ~FrameDataBuffer();
+
+    FrameDataBuffer(const FrameDataBuffer &) = delete;
+    FrameDataBuffer &operator=(const FrameDataBuffer &) = delete;
+
+    /**
+     * @brief Upload the data of the frame, this is the only uniform upload needed
+     * for the camera whatever the number of programs used during the frame
+     *
+     * @param data The data of the current frame
+     */
+    void update(const FrameData &data);
+
+private:
+    GLuint m_ID;
+};
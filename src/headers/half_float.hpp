@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Conversions between 32 bits floats and the 16 bits floats of GL_HALF_FLOAT textures
+ *
+ * Floats are rounded to the nearest half, ties to even, like the driver would. Values above the range
+ * become infinities and NaNs stay NaNs. Batches use the F16C instructions when the compiler targets them,
+ * SSE2 otherwise, both giving the same bits as the scalar path except for NaN payloads.
+ *
+ * @note Can be called from any thread
+ */
+class HalfFloat
+{
+public:
+    static uint16_t fromFloat(float value);
+    static float toFloat(uint16_t value);
+
+    /**
+     * @brief Convert a batch of floats, the buffers can't overlap
+     */
+    static void fromFloats(const float *source, uint16_t *destination, size_t count);
+};
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+/**
+ * @brief 64 bits FNV-1a hash
+ *
+ * @param str The string to hash
+ * @param hash The hash to continue from, allows hashing several strings one after the other
+ * @return uint64_t
+ */
+constexpr uint64_t fnv1a(std::string_view str, uint64_t hash = 0xcbf29ce484222325ull) {
+    for (char c : str) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
@@ -3,6 +3,7 @@
 #include <iostream>
 #include <fstream>
 #include <chrono>
+#include <mutex>
 
 class Logger
 {
@@ -39,6 +40,9 @@ public:
     };
 
     void log(LogLevel level, std::string message) {
+        // Worker threads log too, std::localtime and the streams aren't thread safe
+        std::lock_guard<std::mutex> lock(m_mutex);
+
         auto now = std::chrono::system_clock::now();
         auto now_c = std::chrono::system_clock::to_time_t(now);
         std::tm *tm = std::localtime(&now_c);
@@ -51,7 +55,6 @@ public:
         }
 
         std::string logMessage = std::string(LogLevelNames[level]) + " " + std::string(buffer) + " " + message + "\n";
-
         if (m_fileLog) {
             m_logfile << logMessage;
             m_logfile.flush();
@@ -131,6 +134,7 @@ private:
     bool m_consoleLog = true;
     bool m_fileLog = true;
     std::ofstream m_logfile;
+    std::mutex m_mutex;
 
     inline static const char* const LogLevelNames[6] = {
         "",
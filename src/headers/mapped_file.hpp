@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Read only view of a whole file mapped in memory
+ *
+ * Pages are only read from the disk when they're touched. On systems without mmap the file is read in memory instead.
+ */
+class MappedFile
+{
+public:
+    /**
+     * @brief Map the file, @ref isOpen tells if it succeeded
+     */
+    explicit MappedFile(const std::string &path);
+
+    /**
+     * @brief Unmap the file, pointers returned by @ref data become invalid
+     */
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    bool isOpen() const {
+        return m_data != nullptr;
+    }
+
+    const unsigned char *data() const {
+        return m_data;
+    }
+
+    size_t size() const {
+        return m_size;
+    }
+
+private:
+    const unsigned char *m_data = nullptr;
+    size_t m_size = 0;
+    // Holds the file when it can't be mapped
+    std::vector<unsigned char> m_fallback;
+};
@@ -2,6 +2,8 @@
 
 #include <glm/glm.hpp>
 
+#include "texture_atlas.hpp"
+
 // http://devernay.free.fr/cours/opengl/materials.html
 
 class Material
@@ -16,10 +18,15 @@ public:
     Material* withDiffuse(glm::vec3 diffuse);
     Material* withSpecular(glm::vec3 specular);
     Material* withShininess(float shininess);
+    // Maps sampled from a TextureAtlas, materials sharing an atlas are drawn without rebinding it
+    Material* withDiffuseMap(const AtlasRegion& region);
+    Material* withSpecularMap(const AtlasRegion& region);
 
     glm::vec3 getAmbient();
     glm::vec3 getDiffuse();
     glm::vec3 getSpecular();
+    const AtlasRegion& getDiffuseMap();
+    const AtlasRegion& getSpecularMap();
 
     // this function exist to have the "real" value of the shininess, between 0 and 1
     float getRealShininess();
@@ -33,6 +40,7 @@ private:
               diffuse   = glm::vec3(0.01f, 0.01f, 0.01f),
               specular  = glm::vec3(0.5f, 0.5f, 0.5f);
     float     shininess = 0.25;
+    AtlasRegion diffuseMap, specularMap;
 
     Material(){ }
 
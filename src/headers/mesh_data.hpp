@@ -0,0 +1,109 @@
+#pragma once
+
+#include "glad/glad.h"
+#include <glm/glm.hpp>
+
+#include "vertex_format.hpp"
+
+#include <cfloat>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Vertex of the meshes owned by the engine, the same layout as the test cube
+ */
+struct MeshVertex {
+    glm::vec3 position;
+    glm::vec3 normal;
+    glm::vec2 texCoords;
+};
+
+/**
+ * @brief Layouts of the vertex buffers, MeshVertex or one of the compact layouts of VertexQuantization
+ *
+ * The values are stored in cooked files and never change.
+ */
+enum class VertexLayout : uint32_t {
+    // MeshVertex, 32 bytes
+    FLOAT = 0,
+    // unorm16 positions in the bounds, octahedral snorm16 normals, half float texture coordinates, 16 bytes
+    COMPACT_HALF_UV = 1,
+    // Same with unorm16 texture coordinates in the range the mesh uses, 16 bytes
+    COMPACT_UNORM_UV = 2
+};
+
+/**
+ * @brief Axis aligned bounding box, empty until a point is added
+ */
+struct MeshBounds {
+    glm::vec3 min = glm::vec3(FLT_MAX);
+    glm::vec3 max = glm::vec3(-FLT_MAX);
+
+    void extend(const glm::vec3 &point) {
+        min = glm::min(min, point);
+        max = glm::max(max, point);
+    }
+
+    void extend(const MeshBounds &bounds) {
+        min = glm::min(min, bounds.min);
+        max = glm::max(max, bounds.max);
+    }
+
+    glm::vec3 center() const {
+        return (min + max) * 0.5f;
+    }
+
+    /**
+     * @brief Radius of the sphere around @ref center enclosing the box
+     */
+    float radius() const {
+        return glm::length(max - min) * 0.5f;
+    }
+};
+
+/**
+ * @brief Textures of a material, paths relative to the working directory, empty when the material has none
+ */
+struct MeshMaterial {
+    std::string diffuse;
+    std::string specular;
+};
+
+/**
+ * @brief Range of the index buffer drawn with one material
+ */
+struct Submesh {
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+    uint32_t material = 0;
+    MeshBounds bounds;
+};
+
+/**
+ * @brief Geometry of a whole model in engine owned arrays, built off the GL thread
+ *
+ * Every submesh shares the vertex and index buffers, indices are absolute in the vertex buffer.
+ */
+struct MeshData {
+    std::vector<MeshVertex> vertices;
+    std::vector<uint32_t> indices;
+    std::vector<Submesh> submeshes;
+    std::vector<MeshMaterial> materials;
+    MeshBounds bounds;
+
+    /**
+     * @brief The layout of @ref MeshVertex, see VertexArrayCache
+     */
+    static VertexFormat vertexFormat() {
+        VertexFormat format;
+        format.stride = sizeof(MeshVertex);
+        format.attributes = {
+            { VertexSemantic::POSITION, 3, GL_FLOAT, GL_FALSE, offsetof(MeshVertex, position) },
+            { VertexSemantic::NORMAL, 3, GL_FLOAT, GL_FALSE, offsetof(MeshVertex, normal) },
+            { VertexSemantic::TEXCOORD, 2, GL_FLOAT, GL_FALSE, offsetof(MeshVertex, texCoords) },
+        };
+        return format;
+    }
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "mesh_data.hpp"
+#include "mapped_file.hpp"
+#include "vertex_quantization.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Binary meshes written by mesh-cook, mapped at runtime and handed to the driver without any parsing
+ *
+ * The file starts with a header followed by the vertex stream, the index buffer, the submeshes,
+ * the materials and their texture paths, every section starting on 16 bytes. Everything is little endian.
+ * The vertex stream is in one of the layouts of @ref VertexLayout, with the ranges needed to decode the compact ones in the header.
+ * Texture paths are stored relative to the file, which is resolved back to the textures of the source model.
+ */
+class MeshFile
+{
+public:
+    static constexpr uint32_t VERSION = 2;
+
+    /**
+     * @brief Get the path of the file mesh-cook writes for a model, under COOKED_DIRECTORY with the .mesh extension
+     */
+    static std::string cookedPath(const std::string &filename);
+
+    /**
+     * @brief Returns true if the cooked file of a model exists and is at least as recent as the model
+     */
+    static bool isCooked(const std::string &filename);
+
+    /**
+     * @brief Write a mesh, through a temporary file renamed once complete
+     *
+     * @param layout The layout of the vertex stream
+     * @return false if the file can't be written
+     */
+    static bool write(const std::string &filename, const MeshData &mesh, VertexLayout layout);
+
+    /**
+     * @brief Map a cooked file and check its header, can be called from any thread
+     *
+     * @return false if the file can't be mapped, is truncated or was written by another version
+     */
+    bool open(const std::string &filename);
+
+    const void *getVertices() const;
+    size_t getVertexBytes() const;
+    VertexLayout getVertexLayout() const;
+
+    /**
+     * @brief Get the ranges the vertices of a compact layout were quantized in
+     */
+    VertexQuantization::Decode getDecode() const;
+
+    const void *getIndices() const;
+    size_t getIndexBytes() const;
+
+    /**
+     * @brief Get the type of the indices, GL_UNSIGNED_SHORT when the mesh has few enough vertices, GL_UNSIGNED_INT otherwise
+     */
+    GLenum getIndexType() const;
+
+    std::vector<Submesh> getSubmeshes() const;
+
+    /**
+     * @brief Get the materials, their texture paths are relative to the working directory
+     */
+    std::vector<MeshMaterial> getMaterials() const;
+
+    MeshBounds getBounds() const;
+
+private:
+    struct Header;
+
+    std::unique_ptr<MappedFile> m_file;
+    const Header *m_header = nullptr;
+    std::string m_directory;
+};
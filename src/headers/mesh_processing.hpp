@@ -0,0 +1,103 @@
+#pragma once
+
+#include "glad/glad.h"
+
+#include "mesh_data.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Offline and load time passes over @ref MeshData, turning triangle soups into compact indexed geometry
+ *
+ * @note Can be called from any thread, never touches OpenGL
+ */
+class MeshProcessing
+{
+public:
+    /**
+     * @brief Efficiency of the post transform cache over an index buffer, simulated as a FIFO
+     */
+    struct CacheStats {
+        // Average cache miss ratio, vertices transformed per triangle, between 0.5 and 3
+        float acmr = 0.0f;
+        // Average transform to vertex ratio, vertices transformed per vertex of the mesh, 1 at best
+        float atvr = 0.0f;
+    };
+
+    /**
+     * @brief Cache statistics before and after @ref optimize
+     */
+    struct OptimizeStats {
+        CacheStats before;
+        CacheStats after;
+    };
+
+    /**
+     * @brief Size of the simulated post transform cache, close to what current hardware keeps per batch
+     */
+    static constexpr size_t CACHE_SIZE = 16;
+
+    /**
+     * @brief Simulate a FIFO post transform cache over the triangles of every submesh, the cache starting empty on each submesh
+     */
+    static CacheStats analyzeVertexCache(const MeshData &mesh, size_t cacheSize = CACHE_SIZE);
+
+    /**
+     * @brief Reorder the triangles of each submesh so their vertices stay in the post transform cache, with Forsyth's scoring
+     */
+    static void optimizeVertexCache(MeshData &mesh);
+
+    /**
+     * @brief Reorder clusters of triangles of each submesh so that the ones likely to occlude the others are drawn first
+     *
+     * Clusters are split where the cache order already misses every vertex, then sorted by how much they face away from
+     * the center of the submesh. Submeshes whose cache miss ratio would grow by more than the threshold keep their order.
+     *
+     * @param threshold The largest ratio between the cache miss ratio after and before, 1.05 allows 5% more misses
+     */
+    static void optimizeOverdraw(MeshData &mesh, float threshold = 1.05f);
+
+    /**
+     * @brief Reorder the vertices in the order the triangles first use them, so vertex fetches stream through memory
+     *
+     * Vertices no triangle uses are removed.
+     */
+    static void optimizeVertexFetch(MeshData &mesh);
+
+    /**
+     * @brief Run the vertex cache, overdraw and vertex fetch passes in that order
+     */
+    static OptimizeStats optimize(MeshData &mesh);
+
+    /**
+     * @brief Merge the vertices having the same position, normal and texture coordinates and remap the indices
+     *
+     * Vertices are compared bit for bit through a hash of their attributes, so only exact duplicates are merged.
+     * The first occurrence of each vertex is kept, in order, submeshes and bounds are left untouched.
+     *
+     * @return The number of vertices removed
+     */
+    static size_t weld(MeshData &mesh);
+
+    /**
+     * @brief Build a welded, indexed mesh from a triangle list of three vertices per triangle, as a single submesh
+     */
+    static MeshData fromTriangles(const MeshVertex *vertices, size_t count);
+
+    /**
+     * @brief Get the smallest index type addressing every vertex, GL_UNSIGNED_SHORT up to 65536 vertices and GL_UNSIGNED_INT above
+     */
+    static GLenum indexType(size_t vertexCount);
+
+    /**
+     * @brief Get the size in bytes of an index of the given type
+     */
+    static size_t indexSize(GLenum type);
+
+    /**
+     * @brief Narrow the indices to the given type, ready to be uploaded
+     */
+    static std::vector<uint8_t> packIndices(const std::vector<uint32_t> &indices, GLenum type);
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "texture_image.hpp"
+
+#include <string>
+
+/**
+ * @brief Builds the mip chain of an image on the CPU, so the GL thread only uploads prebuilt levels
+ *
+ * Levels are filtered from the previous one in linear floating point, with separable kernels
+ * applied with SSE, or AVX2 when the compiler targets it. 8 bits images can be sRGB encoded,
+ * their colors are then decoded before filtering and encoded again afterwards, alpha always stays linear.
+ *
+ * @note Can be called from any thread
+ */
+class MipGenerator
+{
+public:
+    enum class Filter {
+        BOX,
+        KAISER,
+        LANCZOS
+    };
+
+    struct Options {
+        Filter filter = Filter::KAISER;
+        // Only used by 8 bits images with at least three channels
+        bool srgb = false;
+        // Texels on an edge are filtered with the opposite one, like GL_REPEAT samples them
+        bool wrap = true;
+    };
+
+    /**
+     * @brief Replace the levels of an image by its base level followed by every smaller level down to 1x1
+     *
+     * @param image An image of 1 to 4 channels of GL_UNSIGNED_BYTE or GL_FLOAT, compressed images are left untouched
+     * @return false if the image can't be filtered
+     */
+    static bool generate(TextureImage &image, const Options &options);
+
+    /**
+     * @brief Describe the options, to be part of the keys of the caches holding generated levels
+     */
+    static std::string describe(const Options &options);
+};
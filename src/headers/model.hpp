@@ -0,0 +1,116 @@
+#pragma once
+
+#include "glad/glad.h"
+#include <glm/glm.hpp>
+
+#include "mesh_data.hpp"
+#include "mesh_file.hpp"
+#include "shader.hpp"
+#include "texture_handle.hpp"
+#include "vertex_quantization.hpp"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief A model imported on the loader threads, drawn once its buffers are uploaded
+ *
+ * The file is read and converted to engine owned arrays by @ref ModelImporter on a loader thread,
+ * the GL thread only creates the buffers and acquires the textures, the first time the model is drawn after the import finished.
+ * Models cooked by mesh-cook skip assimp entirely, their @ref MeshFile is mapped and its streams handed to the driver as they are.
+ */
+class Model
+{
+public:
+    /**
+     * @brief Start importing a model, returns immediately
+     *
+     * @param path The path to the model file, any format assimp reads
+     * @param position Where the model is placed in the world
+     * @param optimize Reorder the geometry for the post transform cache when the model isn't cooked, cooked models already are
+     */
+    Model(std::string path, glm::vec3 position, bool optimize = true);
+    ~Model();
+
+    Model(const Model &) = delete;
+    Model &operator=(const Model &) = delete;
+
+    /**
+     * @brief Get how much of the import is done, between 0 and 1
+     */
+    float getProgress() const;
+
+    /**
+     * @brief Returns true once the buffers are uploaded and the model can be drawn
+     */
+    bool isReady() const {
+        return m_vertexBuffer != 0;
+    }
+
+    /**
+     * @brief Returns true if the file couldn't be imported, the model is then never drawn
+     */
+    bool hasFailed() const;
+
+    const glm::mat4 &getTransform() const {
+        return m_transform;
+    }
+
+    /**
+     * @brief Get the bounds of the model in world space, empty until the import is done
+     */
+    MeshBounds getBounds() const;
+
+    /**
+     * @brief Get the layout of the vertices, FLOAT until the import is done, compact for models cooked in one
+     */
+    VertexLayout getVertexLayout() const;
+
+    /**
+     * @brief Draw every submesh with its textures on units 0 and 1, uploads the buffers first if the import just finished
+     *
+     * @param shader A ready shader with the inputs of @ref getVertexLayout, sampling material.diffuse and material.specular.
+     * Compact layouts need the COMPACT_VERTEX variant of light.vs
+     * @param screenSize The size of the model on the screen in pixels, used to stream its textures, see Camera::projectedSize
+     */
+    void draw(const Shader &shader, float screenSize);
+
+private:
+    /**
+     * @brief State shared with the import job, which may outlive the model
+     */
+    struct Import {
+        std::atomic<float> progress{ 0.0f };
+        std::atomic<bool> done{ false };
+        bool succeeded = false;
+        // Holds the geometry when the model is cooked, mesh is left empty
+        MeshFile cooked;
+        bool fromCooked = false;
+        MeshData mesh;
+    };
+
+    /**
+     * @brief Create the buffers and acquire the textures of a finished import, to be called from the GL thread
+     */
+    void upload();
+
+    std::string m_path;
+    glm::mat4 m_transform;
+    std::shared_ptr<Import> m_import;
+
+    GLuint m_vertexBuffer = 0;
+    GLuint m_indexBuffer = 0;
+    GLenum m_indexType = GL_UNSIGNED_INT;
+    VertexLayout m_layout = VertexLayout::FLOAT;
+    VertexQuantization::Decode m_decode;
+    std::vector<Submesh> m_submeshes;
+    MeshBounds m_bounds;
+
+    struct Material {
+        TextureHandle diffuse;
+        TextureHandle specular;
+    };
+    std::vector<Material> m_materials;
+};
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "mesh_data.hpp"
+
+#include <atomic>
+#include <string>
+
+/**
+ * @brief Converts the scenes read by assimp into @ref MeshData
+ *
+ * Each thread has its own Assimp::Importer, created on its first import and reused by the next ones,
+ * so several models can be imported at once on the loader threads.
+ *
+ * @note Can be called from any thread, never touches OpenGL
+ */
+class ModelImporter
+{
+public:
+    /**
+     * @brief Read a model file and flatten its node hierarchy into a single mesh, one submesh per assimp mesh
+     *
+     * @param progress Written with the progress of the import between 0 and 1 when not null
+     * @param optimize Reorder the triangles and vertices for the post transform cache and overdraw, see MeshProcessing::optimize
+     * @return false if assimp can't read the file
+     */
+    static bool import(const std::string &filename, MeshData &mesh, std::atomic<float> *progress = nullptr, bool optimize = false);
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "glad/glad.h"
+
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief On disk cache of linked program binaries, using glGetProgramBinary and glProgramBinary
+ *
+ * Entries are keyed by a hash of both shader sources and of the GL_RENDERER and GL_VERSION strings,
+ * so a driver update or a source change simply misses the cache.
+ * Every binary rejected by the driver is removed and the program is compiled from sources instead.
+ */
+class ProgramCache
+{
+public:
+    /**
+     * @brief Compute the key of a program
+     *
+     * @note Needs a current OpenGL context to query the renderer and the version
+     */
+    static uint64_t key(const std::string &vertexCode, const std::string &fragmentCode);
+
+    /**
+     * @brief Submit the program binary stored for the key to the program
+     *
+     * The link status isn't queried here so the driver can keep working in the background,
+     * @ref validate must be called before using the program.
+     *
+     * @param program A program without any shader attached
+     * @param key The key computed by @ref key
+     * @return true if a binary has been submitted
+     */
+    static bool load(GLuint program, uint64_t key);
+
+    /**
+     * @brief Check if the driver accepted the binary submitted by @ref load,
+     * a rejected binary is removed from the cache
+     *
+     * @return true if the program is linked and ready to be used
+     */
+    static bool validate(GLuint program, uint64_t key);
+
+    /**
+     * @brief Store the binary of a linked program
+     *
+     * @note The program must have been linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+     */
+    static void store(GLuint program, uint64_t key);
+
+    /**
+     * @brief Returns true if the driver supports at least one program binary format
+     */
+    static bool isSupported();
+
+    static unsigned int getHits() {
+        return s_hits;
+    }
+
+    static unsigned int getMisses() {
+        return s_misses;
+    }
+
+private:
+    static std::string path(uint64_t key);
+
+    inline static const std::string s_directory = "cache/shaders/";
+    inline static unsigned int s_hits = 0;
+    inline static unsigned int s_misses = 0;
+};
@@ -8,6 +8,9 @@
 #include "camera.hpp"
 #include "shader.hpp"
 #include "material.hpp"
+#include "model.hpp"
+
+#include <vector>
 
 class Scene {
 
@@ -43,6 +46,11 @@ public:
     void addMaterial(std::string name, Material* material);
     std::map<std::string, Material*> getMaterials();  
 
+    /**
+     * @brief Add a model to draw, it shows up once its import is done
+     */
+    void addModel(Model* model);
+
     static uint16_t width;
     static uint16_t height;
 
@@ -50,6 +58,9 @@ private:
     GLFWwindow* window;    
     std::map<std::string, Shader*> shaders;
     std::map<std::string, Material*> materials;
+    std::vector<Model*> models;
+    // Holds the maps of the materials, deleted with the GL context
+    TextureAtlas* atlas = nullptr;
 
     /**
      * @brief Init all the libraries and generate a windows
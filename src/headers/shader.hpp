@@ -4,27 +4,118 @@
 #include "glm/glm.hpp"
 #include "glm/gtc/type_ptr.hpp"
 
+#include "uniform.hpp"
+#include "shader_preprocessor.hpp"
+
+#include <chrono>
+#include <cstring>
 #include <string>
+#include <unordered_map>
+#include <vector>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 
+/**
+ * @brief Counters about the uniform traffic, shared by every Shader and reset each frame
+ */
+struct ShaderStats {
+    // Number of glGetUniformLocation calls, only expected while programs are linked
+    unsigned int driverLookups = 0;
+    // Number of setters called with a name which isn't an active uniform of the program
+    unsigned int unknownUniforms = 0;
+    // Number of glUniform* calls issued, and skipped because the value didn't change
+    unsigned int issuedUploads = 0;
+    unsigned int skippedUploads = 0;
+    // Number of glUseProgram calls issued, and skipped because the program was already bound
+    unsigned int issuedBinds = 0;
+    unsigned int skippedBinds = 0;
+    // Number of isReady calls on programs the driver is still compiling
+    unsigned int pendingPrograms = 0;
+};
+
+/**
+ * @brief Description of an active vertex input, as reported by the driver after linking
+ */
+struct AttributeInfo {
+    std::string name;
+    GLint location;
+    GLenum type;
+    GLint size;
+};
+
+/**
+ * @brief Description of an active uniform block, as reported by the driver after linking
+ */
+struct UniformBlockInfo {
+    std::string name;
+    GLuint index;
+    GLint size;
+};
+
 class Shader
 {
 public:
+    enum Status {
+        UNSUBMITTED,
+        PENDING,
+        READY,
+        FAILED
+    };
+
     /**
      * @brief Construct a new Shader object
      *
+     * @note Nothing is compiled until the shader is submitted, see @ref submitAll
+     *
+     * @param vertexPath The path to the vertex shader
+     * @param fragmentPath The path to the fragment shader
+     * @param defines The feature keys injected in both stages, see @ref ShaderPreprocessor
+     */
+    Shader(const char *vertexPath, const char *fragmentPath, const ShaderDefines &defines = {});
+
+    /**
+     * @brief Get the variant of a shader specialized with the given defines,
+     * each (sources, defines) pair is created once and identified by its permutation key
+     *
      * @param vertexPath The path to the vertex shader
      * @param fragmentPath The path to the fragment shader
+     * @param defines The feature keys of the variant
+     * @return Shader* The variant, owned by the variant cache
      */
-    Shader(const char *vertexPath, const char *fragmentPath);
+    static Shader *getVariant(const char *vertexPath, const char *fragmentPath, const ShaderDefines &defines = {});
+
+    /**
+     * @brief Hand every shader to the driver without waiting for any of them,
+     * so drivers able to compile in parallel get the whole batch at once
+     *
+     * @param shaders The shaders to compile
+     */
+    static void submitAll(const std::vector<Shader *> &shaders);
+
+    /**
+     * @brief Read the sources and hand them to the driver, without waiting for the result
+     */
+    void submit();
+
+    /**
+     * @brief Check if the program can be used, never stalls when GL_KHR_parallel_shader_compile
+     * is available. Programs still compiling are counted as pending in the frame stats.
+     *
+     * @return true if the program is linked and its uniforms reflected
+     */
+    bool isReady();
+
+    Status getStatus() const {
+        return m_status;
+    }
 
     /**
      * @brief Tells opengl to use this Shader as the program
      * This needs to be called when setting up uniforms or
      * trying to render with this shader
      *
+     * @note Does nothing if the program is already the current one
      */
     void use();
 
@@ -42,6 +133,36 @@ public:
     void setVec3(const std::string &, const glm::vec3 &value) const;
     void setVec2(const std::string &name, const glm::vec2 &value) const;
 
+    /**
+     * @brief Set a uniform through a handle, this is the path meant for the render loop
+     * since it doesn't allocate nor hash any string.
+     * The setters taking a std::string above are kept as a slow path for tools.
+     *
+     * @param uniform The handle of the uniform
+     * @param value The value of the uniform
+     */
+    template <typename T>
+    void set(Uniform<T> uniform, const T &value) const {
+        static_assert(sizeof(T) <= sizeof(UniformShadow::data), "Uniform type too large for its shadow");
+
+        int index = findUniform(uniform.hash);
+        if (index == -1) {
+            return;
+        }
+
+        // Skip the driver call when the program already holds this value
+        UniformShadow &shadow = m_shadows[index];
+        if (shadow.valid && std::memcmp(shadow.data, &value, sizeof(T)) == 0) {
+            s_frameStats.skippedUploads++;
+            return;
+        }
+        std::memcpy(shadow.data, &value, sizeof(T));
+        shadow.valid = true;
+
+        s_frameStats.issuedUploads++;
+        upload(m_uniforms.getUniforms()[index].location, value);
+    }
+
     /**
      * @brief Get the Id of the shader program
      *
@@ -51,12 +172,184 @@ public:
         return ID;
     }
 
+    /**
+     * @brief Read the sources again and rebuild the program,
+     * the current program stays in use until the new one is successfully linked
+     */
     void reload();
 
+    /**
+     * @brief Rebuild the program from already preprocessed sources, doesn't touch any file
+     * so it can be called from the frame thread.
+     * The current program stays in use until the new one is successfully linked,
+     * and is kept if the new one fails to compile.
+     *
+     * @param vertexCode The preprocessed vertex shader
+     * @param fragmentCode The preprocessed fragment shader
+     * @param dependencies Every file read to build both stages
+     */
+    void reload(const std::string &vertexCode, const std::string &fragmentCode, const std::vector<std::string> &dependencies);
+
+    const char *getVertexPath() const {
+        return vertexPath;
+    }
+
+    const char *getFragmentPath() const {
+        return fragmentPath;
+    }
+
+    const ShaderDefines &getDefines() const {
+        return m_defines;
+    }
+
+    /**
+     * @brief Get every file read to build both stages, including the #include'd ones
+     */
+    const std::vector<std::string> &getDependencies() const {
+        return m_dependencies;
+    }
+
+    /**
+     * @brief Get the uniforms reflected from the program when it was linked
+     */
+    const std::vector<UniformInfo> &getUniforms() const {
+        return m_uniforms.getUniforms();
+    }
+
+    /**
+     * @brief Get the vertex inputs reflected from the program when it was linked, sorted by location
+     */
+    const std::vector<AttributeInfo> &getAttributes() const {
+        return m_attributes;
+    }
+
+    /**
+     * @brief Get the uniform blocks reflected from the program when it was linked
+     */
+    const std::vector<UniformBlockInfo> &getUniformBlocks() const {
+        return m_uniformBlocks;
+    }
+
+    /**
+     * @brief Get a hash of the vertex inputs, programs with the same hash accept the same vertex arrays
+     */
+    uint64_t getInterfaceHash() const {
+        return m_interfaceHash;
+    }
+
+    /**
+     * @brief Get the counters accumulated since the last @ref resetFrameStats
+     */
+    static const ShaderStats &getFrameStats() {
+        return s_frameStats;
+    }
+
+    static void resetFrameStats() {
+        s_frameStats = ShaderStats{};
+    }
+
 private:
-    unsigned int ID;
+    unsigned int ID = 0;
     const char *vertexPath;
     const char *fragmentPath;
+    ShaderDefines m_defines;
+    // Every file read to build both stages, including the #include'd ones
+    std::vector<std::string> m_dependencies;
+    UniformTable m_uniforms;
+    std::vector<AttributeInfo> m_attributes;
+    std::vector<UniformBlockInfo> m_uniformBlocks;
+    uint64_t m_interfaceHash = 0;
+
+    Status m_status = UNSUBMITTED;
+    // Program being built, swapped with ID once successfully linked
+    unsigned int m_building = 0;
+    // Shaders being compiled, only valid while m_building isn't loaded from a binary
+    unsigned int m_vertex = 0, m_fragment = 0;
+    // Sources kept while a cached binary is pending, to compile them if the driver rejects it
+    std::string m_vertexCode, m_fragmentCode;
+    uint64_t m_cacheKey = 0;
+    bool m_cacheable = false;
+    bool m_fromBinary = false;
+
+    /**
+     * @brief Last value uploaded to a uniform, the largest supported type is a mat4
+     */
+    struct UniformShadow {
+        bool valid = false;
+        unsigned char data[sizeof(glm::mat4)];
+    };
+    // One shadow per entry of m_uniforms, aliases share the shadow of the uniform they point to
+    mutable std::vector<UniformShadow> m_shadows;
+
+    static ShaderStats s_frameStats;
+    // The program currently bound with glUseProgram, shared by every Shader
+    static unsigned int s_boundProgram;
+    // Number of programs submitted and not finished yet, and when the last batch was submitted
+    static unsigned int s_pending;
+    static std::chrono::steady_clock::time_point s_batchStart;
+    static bool s_batchRunning;
+    // Variants created by getVariant, indexed by permutation key
+    static std::unordered_map<uint64_t, Shader *> s_variants;
+
+    /**
+     * @brief Read and preprocess both shader files
+     *
+     * @return false if one of the files can't be read
+     */
+    bool readSources(std::string &vertexCode, std::string &fragmentCode);
+
+    /**
+     * @brief Create the program from the binary cache or from the sources, without querying any status
+     *
+     * @param useCache false to skip the binary cache
+     */
+    void submit(const std::string &vertexCode, const std::string &fragmentCode, bool useCache);
+
+    /**
+     * @brief Abandon the program being built, if any
+     */
+    void cancelBuild();
+    void submitSources(const std::string &vertexCode, const std::string &fragmentCode);
+
+    /**
+     * @brief Check if the driver is done with the program being built,
+     * and if so check for errors, swap it in and reflect its uniforms
+     */
+    void poll();
+    void finish(Status status);
+
+    static bool parallelCompileSupported();
+
+    /**
+     * @brief Fill the uniform table from the GL_ACTIVE_UNIFORMS of the linked program
+     */
+    void reflectUniforms();
+
+    /**
+     * @brief Fill the vertex inputs and uniform blocks from the linked program
+     */
+    void reflectInterface();
+    void registerUniform(const UniformInfo &info);
+
+    /**
+     * @brief Find a uniform in the reflected table, without asking the driver
+     *
+     * @param hash The FNV-1a hash of the uniform name
+     * @return int The index of the uniform in m_uniforms, -1 if it isn't active in the program
+     */
+    int findUniform(uint64_t hash) const;
+
+    /**
+     * @brief Issue the glUniform* call matching the type of the value
+     */
+    static void upload(GLint location, bool value);
+    static void upload(GLint location, int value);
+    static void upload(GLint location, float value);
+    static void upload(GLint location, const glm::vec2 &value);
+    static void upload(GLint location, const glm::vec3 &value);
+    static void upload(GLint location, const glm::vec4 &value);
+    static void upload(GLint location, const glm::mat3 &value);
+    static void upload(GLint location, const glm::mat4 &value);
 
     /**
      * @brief Check for errors when compiling and linking shaders
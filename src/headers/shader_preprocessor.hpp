@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Feature keys injected as #define in every stage of a shader variant, e.g.
+ * { { "NORMAL_MAP", "" }, { "NUM_LIGHTS", "4" } }
+ * The map keeps them sorted so the same set always gives the same permutation key.
+ */
+using ShaderDefines = std::map<std::string, std::string>;
+
+class ShaderPreprocessor
+{
+public:
+    /**
+     * @brief Resolve the #include directives of a GLSL file and inject the defines right after its #version
+     *
+     * Included paths are relative to the including file, each file is included at most once.
+     * #line directives are emitted so compilation errors point at the right line, the source string
+     * number being the index of the file in dependencies.
+     *
+     * @param path The path to the shader
+     * @param defines The defines of the variant
+     * @param output The processed source
+     * @param dependencies Every file read to build the output, starting with path
+     * @return false if a file can't be read
+     */
+    static bool process(const std::string &path, const ShaderDefines &defines, std::string &output, std::vector<std::string> &dependencies);
+
+    /**
+     * @brief Compute the 64 bits key of a variant
+     *
+     * @param vertexPath The path to the vertex shader
+     * @param fragmentPath The path to the fragment shader
+     * @param defines The defines of the variant
+     * @return uint64_t
+     */
+    static uint64_t permutationKey(const std::string &vertexPath, const std::string &fragmentPath, const ShaderDefines &defines);
+
+private:
+    static bool include(const std::string &path, const ShaderDefines *defines, std::string &output,
+                        std::vector<std::string> &dependencies, std::set<std::string> &included);
+};
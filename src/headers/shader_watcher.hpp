@@ -0,0 +1,73 @@
+#pragma once
+
+#include "shader.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Watches a shader directory with inotify and hot-reloads the shaders using the modified files
+ *
+ * Files are read and preprocessed on a worker thread, once no other change happened for a short
+ * debounce delay. The frame thread only hands the resulting sources to the driver, see @ref update.
+ *
+ * @note Only implemented on Linux, elsewhere the watcher does nothing
+ */
+class ShaderWatcher
+{
+public:
+    /**
+     * @brief Start watching the directory and its sub directories
+     *
+     * @param directory The root directory of the shaders
+     * @param shaders The shaders to reload, they must have been submitted already
+     */
+    ShaderWatcher(const std::string &directory, const std::vector<Shader *> &shaders);
+
+    /**
+     * @brief Stop and join the worker thread
+     */
+    ~ShaderWatcher();
+
+    ShaderWatcher(const ShaderWatcher &) = delete;
+    ShaderWatcher &operator=(const ShaderWatcher &) = delete;
+
+    /**
+     * @brief Submit the sources prepared by the worker, to be called once per frame from the GL thread
+     */
+    void update();
+
+private:
+    /**
+     * @brief What the worker knows about a shader, copied so it never touches the Shader itself
+     */
+    struct Watched {
+        Shader *shader;
+        std::string vertexPath, fragmentPath;
+        ShaderDefines defines;
+        std::vector<std::string> dependencies;
+    };
+
+    /**
+     * @brief Preprocessed sources waiting to be submitted by the frame thread
+     */
+    struct Reload {
+        Shader *shader;
+        std::string vertexCode, fragmentCode;
+        std::vector<std::string> dependencies;
+    };
+
+    std::string m_directory;
+    std::vector<Watched> m_watched;
+
+    std::thread m_thread;
+    std::atomic<bool> m_running{ true };
+    std::mutex m_mutex;
+    std::vector<Reload> m_reloads;
+
+    void run();
+    void rebuild(const std::vector<std::string> &changed);
+};
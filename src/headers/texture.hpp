@@ -4,44 +4,114 @@
 #include <assimp/material.h>
 #include <stb/stb_image.h>
 
+#include "texture_image.hpp"
+#include "texture_handle.hpp"
+#include "mip_generator.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
 #include <string>
 #include <vector>
-#include <map>
+#include <mutex>
+
+/**
+ * @brief Counters about the texture binds, reset each frame
+ */
+struct TextureStats {
+	// Number of glBindTexture calls issued, and skipped because the texture was already bound to the unit
+	unsigned int issuedBinds = 0;
+	unsigned int skippedBinds = 0;
+};
 
 class Texture
 {
 public:
-	/**
-	 * @brief Loads the texture in m_map if it does not already exist
-	 *
-	 * @param flipTextures True if the texture image should be flipped
-	 * when loaded with stb
-	 */
-	static void loadTextureInMemory(std::string, aiTextureType, bool flipTextures);
+	// Texture units whose bindings are tracked, binds to the units above always reach the driver
+	static constexpr GLuint TRACKED_UNITS = 16;
 
 	/**
 	 * @brief Loads and return the texture corresponding to the given file name.
 	 *
-	 * Calls the @ref loadTextureInMemory function to add the texture
-	 * to the map if it does not already exist.
-	 *
+	 * The texture is shared through the @ref TextureCache, it is only loaded
+	 * if it isn't already resident.
 	 *
 	 * @param filename
 	 * @param texture_type The type of the texture (Diffuse, Specular, ...)
 	 * @param flipTextures True if the texture image should be flipped
 	 * when loaded with stb
-	 * @return Texture
+	 * @return TextureHandle keeping the texture resident while it is alive
 	 */
-	static Texture getTextureFromFile(std::string filename, aiTextureType texture_type, bool flipTextures);
+	static TextureHandle getTextureFromFile(std::string filename, aiTextureType texture_type, bool flipTextures);
 
 	/**
 	 * @brief Loads all the textures specified in paths for a Cubemap object
 	 *
-	 * @param paths The paths to the textures
-	 * @return Texture
+	 * The faces are decoded concurrently on the loader threads, then uploaded in immutable storage
+	 * once they're all checked to be square and to share the same size and format. HDR faces are stored as 16F.
+	 *
+	 * @param paths The paths to the 6 faces, in the order of GL_TEXTURE_CUBE_MAP_POSITIVE_X and the following targets
+	 * @return Texture The ID is 0 if a face can't be loaded or doesn't match the others
 	 */
 	static Texture loadCubemap(std::vector<std::string> paths);
 
+	/**
+	 * @brief Stream the textures in, to be called once per frame from the GL thread
+	 *
+	 * Textures decoded by the loader threads get their immutable storage and their smallest levels first,
+	 * then the larger levels requested through @ref request during the previous frame are uploaded one at a time,
+	 * the textures missing the most levels first. Uploads go through a pixel buffer object and stop once the budget is spent,
+	 * one level is always uploaded so a large one can't block the queue.
+	 * When the @ref TextureCache is over its budget, the largest levels of the textures nobody requested are dropped first.
+	 *
+	 * @param budgetBytes The number of bytes that can be uploaded this frame
+	 */
+	static void processUploads(size_t budgetBytes);
+
+	/**
+	 * @brief Get the number of textures decoded and waiting for @ref processUploads
+	 */
+	static size_t getPendingUploads();
+
+	/**
+	 * @brief Get the number of levels requested and not uploaded yet, over every texture
+	 */
+	static size_t getMissingLevels();
+
+	/**
+	 * @brief Ask for the levels needed to draw the texture over a part of the screen this frame
+	 *
+	 * @param pixels The size of the object using the texture on the screen, see Camera::projectedSize
+	 */
+	void request(float pixels);
+
+	/**
+	 * @brief Bind a texture to a texture unit, does nothing if it is already bound there
+	 *
+	 * Every bind of the engine goes through here so the tracked state matches the driver's,
+	 * draws sharing a texture array don't touch the bindings at all.
+	 *
+	 * @param unit The index of the unit, not GL_TEXTURE0 + unit
+	 * @param target GL_TEXTURE_2D, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_CUBE_MAP...
+	 */
+	static void bind(GLuint unit, GLenum target, GLuint texture);
+
+	/**
+	 * @brief Forget a texture about to be deleted, the driver unbinds it and may reuse its name
+	 */
+	static void unbind(GLuint texture);
+
+	/**
+	 * @brief Get the counters accumulated since the last @ref resetFrameStats
+	 */
+	static const TextureStats &getFrameStats() {
+		return s_frameStats;
+	}
+
+	static void resetFrameStats() {
+		s_frameStats = TextureStats{};
+	}
+
 	/**
 	 * @brief Get the Type of the texture
 	 * All different types of texture are specified in the material header of the assimp library
@@ -59,19 +129,143 @@ public:
 	Texture();
 
 private:
+	friend class TextureCache;
+
 	/**
 	 * @brief Construct a new Texture object
+	 *
+	 * The texture starts as a 1x1 placeholder and the image is decoded on the loader threads,
+	 * @ref processUploads then replaces the placeholder by a texture with immutable storage, so @ref getID changes once
 	 * 
 	 * @note Textures parameters are set to GL_REPEAT for S and T
 	 * and GL_LINEAR_MIPMAP_LINEAR for the Mipmap min filter
 	 * 
 	 * @param texture_type 
 	 * @param flipTextures 
+	 * @param cacheId The id of the path in the @ref TextureCache, used to find the texture once decoded
+	 */
+	Texture(std::string path, aiTextureType texture_type, bool flipTextures, uint32_t cacheId);
+
+	/**
+	 * @brief Decode an image file with stb and build its mip chain, can be called from any thread
+	 *
+	 * @param mips How the mip chain is filtered, containers keep the chain they hold
+	 * @return false if the file can't be decoded
+	 */
+	static bool decode(const std::string &filename, bool flipTextures, const MipGenerator::Options &mips, TextureImage &image);
+
+	/**
+	 * @brief Decode a cubemap face as is, HDR files are read with stbi_loadf and kept as half floats, can be called from any thread
+	 */
+	static bool decodeFace(const std::string &filename, TextureImage &image);
+
+	/**
+	 * @brief Convert every level of a GL_FLOAT image to GL_HALF_FLOAT, halving its upload and VRAM size
+	 */
+	static void toHalfFloats(TextureImage &image);
+
+	/**
+	 * @brief Read a KTX2 or DDS file, decoding it on the CPU if the driver can't sample its format
+	 *
+	 * @return false if the file can't be read or flipped
+	 */
+	static bool decodeContainer(const std::string &filename, bool flipTextures, TextureImage &image);
+
+	/**
+	 * @brief Replace the placeholder by immutable storage for every level and upload the smallest ones
+	 *
+	 * @return size_t The number of bytes uploaded
+	 */
+	size_t allocate(TextureImage &&image);
+
+	/**
+	 * @brief Upload a range of levels of the image through the pixel buffer object, the texture must be bound
+	 *
+	 * @param first The largest level to upload
+	 * @param last One past the smallest level to upload
 	 */
-	Texture(std::string path, aiTextureType texture_type, bool flipTextures);
+	void upload(GLint first, GLint last);
+
+	/**
+	 * @brief Change the largest level sampled, the levels above it are accounted as evicted from VRAM
+	 */
+	void setBaseLevel(GLint level);
+
+	/**
+	 * @brief Get the largest level needed by the requests of the last frame
+	 *
+	 * @return GLint The current base level when the texture wasn't requested
+	 */
+	GLint getWantedLevel() const;
+
+	/**
+	 * @brief Get the VRAM used by the levels sampled
+	 */
+	size_t residentBytes() const;
+
+	/**
+	 * @brief Delete the texture object, for the @ref TextureCache when it evicts the texture
+	 */
+	void destroy();
+
+	/**
+	 * @brief Account for a texture whose image is uploaded or failed to load,
+	 * logs how long the loads took once none are left
+	 */
+	static void finishLoad();
 
 	GLuint m_ID;
 	aiTextureType m_texture_type;
 	std::string m_filename;
-	static std::map<std::string, Texture> m_map;
+	uint32_t m_cacheId = 0;
+
+	// Every level of the image, kept until they're all uploaded, usually mapped from the disk cache
+	TextureImage m_image;
+	int m_width = 0;
+	int m_height = 0;
+	// Levels allocated, 0 while the placeholder is used
+	GLint m_levels = 0;
+	// Size of every level in VRAM
+	std::vector<size_t> m_levelBytes;
+	// Largest of the levels uploaded as soon as the image is decoded
+	GLint m_tailLevel = 0;
+	// Largest level uploaded, the levels below it are never uploaded again
+	GLint m_uploadedLevel = 0;
+	// Largest level sampled, GL_TEXTURE_BASE_LEVEL
+	GLint m_baseLevel = 0;
+	// Largest size on the screen requested this frame, in pixels
+	float m_demand = 0.0f;
+	// Textures never requested are drawn by code unaware of streaming, they get every level
+	bool m_requested = false;
+
+	/**
+	 * @brief A decoded image waiting to be uploaded in its texture
+	 */
+	struct PendingUpload {
+		uint32_t cacheId;
+		TextureImage image;
+	};
+
+	static std::mutex s_uploadsMutex;
+	static std::vector<PendingUpload> s_uploads;
+	// Streaming buffer used for every upload, orphaned each time
+	static GLuint s_pixelBuffer;
+
+	/**
+	 * @brief The texture last bound to a unit, a unit only tracks its last target
+	 */
+	struct Binding {
+		GLenum target = 0;
+		GLuint texture = 0;
+	};
+
+	static std::array<Binding, TRACKED_UNITS> s_bindings;
+	static GLuint s_activeUnit;
+	static TextureStats s_frameStats;
+
+	// Textures created and not uploaded yet, only used by the GL thread
+	static size_t s_loading;
+	static std::chrono::steady_clock::time_point s_loadStart;
+	// Cache ids of the textures with levels above their smallest ones, evicted ones are dropped lazily
+	static std::vector<uint32_t> s_streaming;
 };
\ No newline at end of file
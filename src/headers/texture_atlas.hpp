@@ -0,0 +1,161 @@
+#pragma once
+
+#include "glad/glad.h"
+#include "texture_image.hpp"
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Where an image ended up in a @ref TextureAtlas
+ */
+struct AtlasRegion {
+    // Layer of the texture array, -1 if the image couldn't be loaded or packed
+    GLint layer = -1;
+    // Offset of the image in the layer in xy, its scale in zw, both in UV space
+    glm::vec4 rect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+
+    bool isValid() const {
+        return layer >= 0;
+    }
+
+    /**
+     * @brief Move texture coordinates of the image into the layer, for importers baking the remap in their vertices
+     *
+     * @note Regions are clamped to their gutter, coordinates outside [0, 1] don't repeat
+     */
+    glm::vec2 remap(glm::vec2 uv) const {
+        return uv * glm::vec2(rect.z, rect.w) + glm::vec2(rect.x, rect.y);
+    }
+};
+
+/**
+ * @brief Packs images into the layers of a single GL_TEXTURE_2D_ARRAY,
+ * so every material sampling the atlas is drawn without binding another texture
+ *
+ * Images as large as a layer get one of their own, the smaller ones are packed with a skyline
+ * bottom-left heuristic, the largest first. Each packed image is surrounded by a gutter repeating its edges
+ * so the few mip levels of the atlas don't bleed into the neighbours, e.g.
+ * @code
+ * TextureAtlas atlas(2048);
+ * uint32_t bricks = atlas.add("textures/bricks.png", false, true);
+ * atlas.build();
+ * material->withDiffuseMap(atlas.getRegion(bricks));
+ * @endcode
+ */
+class TextureAtlas
+{
+public:
+    // Border repeated around packed images, in texels of the largest level
+    static constexpr int GUTTER = 8;
+    // Levels whose gutter is still at least a texel wide
+    static constexpr GLsizei MAX_LEVELS = 4;
+
+    /**
+     * @param layerSize The width and height of every layer
+     */
+    explicit TextureAtlas(GLsizei layerSize = 2048);
+    ~TextureAtlas();
+
+    TextureAtlas(const TextureAtlas &) = delete;
+    TextureAtlas &operator=(const TextureAtlas &) = delete;
+
+    /**
+     * @brief Queue an image, nothing is read before @ref build
+     *
+     * @param srgb True for color maps, their mips are filtered in linear space like the ones of Texture.
+     * The array stays GL_RGBA8 like every texture of the engine, so a color map and a data map can share it
+     * @return uint32_t The index of the image, see @ref getRegion
+     */
+    uint32_t add(const std::string &filename, bool flipTextures, bool srgb);
+
+    /**
+     * @brief Decode the queued images and build their levels on the loader threads, pack them and upload the texture array
+     *
+     * Blocks until the images are decoded, meant for load time. Images which can't be read
+     * or are larger than a layer are logged and get an invalid region.
+     *
+     * @return false if nothing could be packed
+     */
+    bool build();
+
+    const AtlasRegion &getRegion(uint32_t image) const {
+        return m_regions[image];
+    }
+
+    GLuint getID() const {
+        return m_ID;
+    }
+
+    GLsizei getLayers() const {
+        return m_layers;
+    }
+
+    /**
+     * @brief Bind the texture array, does nothing if it is already bound to the unit, see Texture::bind
+     */
+    void bind(GLuint unit) const;
+
+private:
+    struct Source {
+        std::string filename;
+        bool flip;
+        bool srgb;
+    };
+
+    /**
+     * @brief An image surrounded by its gutter, with its prebuilt levels
+     */
+    struct Image {
+        // Size of the source image, 0 if it couldn't be read
+        int width = 0;
+        int height = 0;
+        int gutter = 0;
+        // RGBA8 levels of the padded image, empty if the image doesn't fit in a layer
+        TextureImage padded;
+    };
+
+    /**
+     * @brief Top edge of the packed area over a span of a layer
+     */
+    struct SkylineNode {
+        int x;
+        int y;
+        int width;
+    };
+
+    /**
+     * @brief Find the lowest position of a layer where a rectangle fits under the layer top
+     *
+     * @return int The index of the node the rectangle starts on, -1 if it doesn't fit
+     */
+    int findPosition(const std::vector<SkylineNode> &skyline, int width, int height, int &x, int &y) const;
+
+    /**
+     * @brief Raise the skyline over a rectangle placed at (x, y)
+     */
+    static void place(std::vector<SkylineNode> &skyline, int index, int x, int y, int width, int height);
+
+    /**
+     * @brief Read an image through the @ref TextureDiskCache, pad it with its gutter and build its levels
+     *
+     * @note Called from the loader threads
+     */
+    static Image decode(const Source &source, GLsizei layerSize, GLsizei levels);
+
+    /**
+     * @brief Upload the levels of a padded image, the texture array must be bound
+     *
+     * @param x, y The corner of the gutter in the layer
+     */
+    static void upload(const Image &image, int x, int y, GLint layer, GLsizei levels);
+
+    GLuint m_ID = 0;
+    GLsizei m_layerSize;
+    GLsizei m_layers = 0;
+
+    std::vector<Source> m_sources;
+    std::vector<AtlasRegion> m_regions;
+};
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "texture.hpp"
+
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Owner of every texture loaded from a file
+ *
+ * Textures are indexed by their interned path and reference counted through @ref TextureHandle.
+ * Textures nobody references stay resident until the VRAM budget is exceeded,
+ * then the least recently released ones are deleted first.
+ *
+ * @note Must only be used from the GL thread
+ */
+class TextureCache
+{
+public:
+	struct Stats {
+		size_t residentBytes;
+		size_t budgetBytes;
+		size_t textures;
+		unsigned int hits;
+		unsigned int misses;
+		unsigned int evictions;
+	};
+
+	/**
+	 * @brief Get a handle on the texture of the file, loading it if it isn't resident
+	 *
+	 * @param filename The path to the image
+	 * @param texture_type The type of the texture (Diffuse, Specular, ...)
+	 * @param flipTextures True if the texture image should be flipped when loaded
+	 * @return TextureHandle
+	 */
+	static TextureHandle acquire(const std::string &filename, aiTextureType texture_type, bool flipTextures);
+
+	/**
+	 * @brief Change the amount of VRAM the cache may use, unreferenced textures are evicted right away if needed
+	 *
+	 * @param megabytes The new budget
+	 */
+	static void setBudget(size_t megabytes);
+
+	static Stats getStats();
+
+	/**
+	 * @brief Get the unique id of a path, the same path always gets the same id
+	 */
+	static uint32_t intern(const std::string &path);
+
+	static const std::string &getPath(uint32_t path);
+
+	/**
+	 * @brief Returns true while the resident bytes exceed the budget
+	 */
+	static bool isOverBudget() {
+		return s_resident > s_budget;
+	}
+
+private:
+	friend class TextureHandle;
+	friend class Texture;
+
+	struct Entry {
+		Texture texture;
+		uint32_t references = 0;
+		size_t bytes = 0;
+		// Position in s_lru, only valid while the texture isn't referenced
+		std::list<uint32_t>::iterator lru;
+		bool evictable = false;
+	};
+
+	static void addReference(uint32_t path);
+	static void release(uint32_t path);
+	static aiTextureType getType(uint32_t path);
+	static GLuint getID(uint32_t path);
+
+	/**
+	 * @brief Get the texture of a path
+	 *
+	 * @return Texture* nullptr if the texture has been evicted, pointers are valid until @ref evict is called
+	 */
+	static Texture *find(uint32_t path);
+
+	/**
+	 * @brief Record the VRAM used by a texture each time its levels change
+	 *
+	 * Doesn't evict anything, @ref evict must be called once the uploads are done.
+	 */
+	static void setResidentBytes(uint32_t path, size_t bytes);
+
+	/**
+	 * @brief Delete unreferenced textures, least recently released first, until the budget is met
+	 */
+	static void evict();
+
+	inline static std::unordered_map<std::string, uint32_t> s_pathIds;
+	inline static std::vector<std::string> s_paths;
+	inline static std::unordered_map<uint32_t, Entry> s_entries;
+	// Unreferenced textures, most recently released first
+	inline static std::list<uint32_t> s_lru;
+
+	inline static size_t s_budget = 512ull * 1024 * 1024;
+	inline static size_t s_resident = 0;
+	inline static unsigned int s_hits = 0;
+	inline static unsigned int s_misses = 0;
+	inline static unsigned int s_evictions = 0;
+};
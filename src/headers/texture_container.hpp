@@ -0,0 +1,91 @@
+#pragma once
+
+#include "glad/glad.h"
+
+#include "mip_generator.hpp"
+#include "texture_image.hpp"
+
+#include <string>
+
+// Defined by GL_EXT_texture_compression_s3tc and GL_EXT_texture_sRGB, which glad hasn't been generated with
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#define GL_COMPRESSED_RGBA_S3TC_DXT3_EXT 0x83F2
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT 0x8C4D
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT 0x8C4E
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+
+/**
+ * @brief Reader of the KTX2 and DDS containers holding block compressed textures (BC1 to BC5 and BC7)
+ *
+ * The mip chain stored in the file is kept as is, nothing is decoded on load.
+ * BC4, BC5 and BC7 are core since OpenGL 4.2, the S3TC formats (BC1 to BC3) are an extension
+ * so they are decoded to RGBA8 on the CPU when the driver doesn't expose it.
+ */
+class TextureContainer
+{
+public:
+    /**
+     * @brief Returns true if the file extension is one of a container, .ktx2 or .dds
+     */
+    static bool isContainer(const std::string &filename);
+
+    /**
+     * @brief Read every mip level of a container, can be called from any thread
+     *
+     * @note Rows are stored top to bottom like in the images read by stb, see @ref flipVertically
+     * @return false if the file can't be read or its format isn't supported
+     */
+    static bool load(const std::string &filename, TextureImage &image);
+
+    /**
+     * @brief Get the path of the file texture-cook writes for an image, under the cooked directory with the .ktx2 extension, see ::cookedPath
+     */
+    static std::string cookedPath(const std::string &filename);
+
+    /**
+     * @brief Returns true if the cooked file of an image exists, is at least as recent as the image
+     * and was cooked by the current texture-cook with the same mip options, see CookedTexture
+     */
+    static bool isCooked(const std::string &filename, const MipGenerator::Options &mips);
+
+    /**
+     * @brief Flip every level upside down by reordering the blocks and the rows of their indices
+     *
+     * @return false for BC7 or for levels whose height isn't a multiple of the block height,
+     * their rows can't be moved without decoding them
+     */
+    static bool flipVertically(TextureImage &image);
+
+    /**
+     * @brief Query the compressed formats supported by the driver,
+     * must be called from the GL thread before @ref isSupported is used on the loader threads
+     */
+    static void querySupport();
+
+    /**
+     * @brief Returns true if the driver can sample the compressed internal format
+     */
+    static bool isSupported(GLenum internalFormat);
+
+    /**
+     * @brief Decode every level of a BC1, BC2 or BC3 image to RGBA8, can be called from any thread
+     *
+     * @return false if the image isn't in one of these formats
+     */
+    static bool decompress(TextureImage &image);
+
+private:
+    static bool loadKtx2(const std::string &filename, const std::vector<unsigned char> &file, TextureImage &image);
+    static bool loadDds(const std::string &filename, const std::vector<unsigned char> &file, TextureImage &image);
+
+    inline static bool s_queried = false;
+    inline static bool s_s3tc = false;
+    inline static bool s_s3tcSrgb = false;
+};
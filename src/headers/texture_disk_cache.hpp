@@ -0,0 +1,59 @@
+#pragma once
+
+#include "texture_image.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief On disk cache of decoded images, so later launches skip stb and the CPU work done after it
+ *
+ * Entries are keyed by a hash of the source file bytes and of the decode options, an edited image simply misses the cache.
+ * Entries are mapped in memory when loaded and the upload reads the pixels straight from the mapping.
+ *
+ * @note Every function can be called from the loader threads
+ */
+class TextureDiskCache
+{
+public:
+    /**
+     * @brief Compute the key of an image
+     *
+     * @param source The bytes of the image file
+     * @param options Every option changing the decoded image, e.g. the flip and how mips are filtered
+     */
+    static uint64_t key(const unsigned char *source, size_t size, const std::string &options);
+
+    /**
+     * @brief Map the entry stored for the key in the image
+     *
+     * @return false if there is no entry or if it is invalid, invalid entries are removed
+     */
+    static bool load(uint64_t key, TextureImage &image);
+
+    /**
+     * @brief Same as load without counting a hit or a miss, to map an entry that was just stored
+     */
+    static bool map(uint64_t key, TextureImage &image);
+
+    /**
+     * @brief Store a decoded image, the entry is written aside and renamed so a concurrent load never sees it partially
+     */
+    static void store(uint64_t key, const TextureImage &image);
+
+    static unsigned int getHits() {
+        return s_hits;
+    }
+
+    static unsigned int getMisses() {
+        return s_misses;
+    }
+
+private:
+    static std::string path(uint64_t key);
+
+    inline static const std::string s_directory = "cache/textures/";
+    inline static std::atomic<unsigned int> s_hits = 0;
+    inline static std::atomic<unsigned int> s_misses = 0;
+};
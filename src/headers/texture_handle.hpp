@@ -0,0 +1,61 @@
+#pragma once
+
+#include "glad/glad.h"
+#include <assimp/material.h>
+
+#include <cstdint>
+
+/**
+ * @brief Reference counted handle on a texture owned by the @ref TextureCache
+ *
+ * Copies share the same reference count, the texture becomes evictable once the last handle is gone.
+ */
+class TextureHandle
+{
+public:
+	TextureHandle() = default;
+	TextureHandle(const TextureHandle &other);
+	TextureHandle(TextureHandle &&other) noexcept;
+	TextureHandle &operator=(const TextureHandle &other);
+	TextureHandle &operator=(TextureHandle &&other) noexcept;
+	~TextureHandle();
+
+	/**
+	 * @brief Returns the ID of the texture generated by opengl,
+	 * it changes once when the placeholder is replaced so it must be queried each time the texture is bound
+	 *
+	 * @return GLuint 0 for an empty handle
+	 */
+	GLuint getID() const;
+
+	/**
+	 * @brief Get the Type of the texture
+	 *
+	 * @return aiTextureType
+	 */
+	aiTextureType getType() const;
+
+	/**
+	 * @brief Ask for the levels needed to draw the texture this frame, see Texture::request
+	 */
+	void request(float pixels) const;
+
+	/**
+	 * @brief Returns false for a default constructed handle
+	 */
+	bool isValid() const {
+		return m_path != INVALID_PATH;
+	}
+
+	static constexpr uint32_t INVALID_PATH = UINT32_MAX;
+
+private:
+	friend class TextureCache;
+
+	/**
+	 * @brief Wrap a reference already counted by the cache
+	 */
+	explicit TextureHandle(uint32_t path) : m_path(path) {}
+
+	uint32_t m_path = INVALID_PATH;
+};
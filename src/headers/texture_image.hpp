@@ -0,0 +1,52 @@
+#pragma once
+
+#include "glad/glad.h"
+
+#include "mapped_file.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Location of one mip level inside the pixels of a @ref TextureImage
+ */
+struct TextureLevel {
+    size_t offset;
+    size_t size;
+    int width;
+    int height;
+};
+
+/**
+ * @brief Pixels of a texture decoded in memory, ready to be uploaded by the GL thread
+ */
+struct TextureImage {
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+
+    GLenum internalFormat = 0;
+    GLenum format = 0;
+    GLenum type = GL_UNSIGNED_BYTE;
+
+    // Block compressed levels are uploaded with glCompressedTexImage2D, format and type are unused
+    bool compressed = false;
+
+    // Every level back to back, starting with the base level
+    std::vector<TextureLevel> levels;
+    std::vector<unsigned char> pixels;
+
+    // Images read from the disk cache point in the mapped entry instead of owning their pixels
+    std::shared_ptr<const MappedFile> mapping;
+    size_t mappingOffset = 0;
+    size_t mappingSize = 0;
+
+    const unsigned char *data() const {
+        return mapping ? mapping->data() + mappingOffset : pixels.data();
+    }
+
+    size_t byteSize() const {
+        return mapping ? mappingSize : pixels.size();
+    }
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Fixed set of worker threads running jobs in submission order
+ *
+ * Jobs must never touch OpenGL, the context only lives on the main thread.
+ */
+class ThreadPool
+{
+public:
+    /**
+     * @brief Start the worker threads
+     *
+     * @param threads Number of workers, at least one
+     */
+    explicit ThreadPool(unsigned int threads);
+
+    /**
+     * @brief Finish the queued jobs and join the workers
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /**
+     * @brief Queue a job
+     *
+     * @return std::future holding the result of the job
+     */
+    template <typename F>
+    auto submit(F &&job) -> std::future<decltype(job())> {
+        using Result = decltype(job());
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(job));
+        std::future<Result> future = task->get_future();
+        push([task]() { (*task)(); });
+        return future;
+    }
+
+    unsigned int size() const {
+        return static_cast<unsigned int>(m_workers.size());
+    }
+
+    /**
+     * @brief The pool shared by the asset loaders, sized after the number of cores
+     */
+    static ThreadPool &loaders();
+
+private:
+    std::vector<std::thread> m_workers;
+    std::deque<std::function<void()>> m_jobs;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_stopping = false;
+
+    void push(std::function<void()> job);
+    void run();
+};
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cmath>
+
+/**
+ * @brief Compute the matrix transforming normals for a model matrix, i.e. the inverse transpose
+ * of its upper 3x3 part. Meant to be computed once per object instead of once per vertex.
+ *
+ * Rotations combined with a uniform scale s skip the inverse: the matrix is then s * R
+ * and its inverse transpose is R / s, which is the matrix divided by s^2.
+ *
+ * @param model The model matrix of the object
+ * @return glm::mat3
+ */
+inline glm::mat3 computeNormalMatrix(const glm::mat4 &model) {
+    glm::mat3 m(model);
+
+    float sx = glm::dot(m[0], m[0]);
+    float sy = glm::dot(m[1], m[1]);
+    float sz = glm::dot(m[2], m[2]);
+    float epsilon = 1e-5f * sx;
+
+    bool uniformScale = std::abs(sx - sy) <= epsilon && std::abs(sx - sz) <= epsilon;
+    bool orthogonal = std::abs(glm::dot(m[0], m[1])) <= epsilon
+                      && std::abs(glm::dot(m[0], m[2])) <= epsilon
+                      && std::abs(glm::dot(m[1], m[2])) <= epsilon;
+
+    if (uniformScale && orthogonal && sx > 0.0f) {
+        return m * (1.0f / sx);
+    }
+    return glm::transpose(glm::inverse(m));
+}
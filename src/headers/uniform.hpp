@@ -0,0 +1,94 @@
+#pragma once
+
+#include "glad/glad.h"
+
+#include "hash.hpp"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Typed handle on a uniform, its name is hashed at compile time
+ *
+ * Handles aren't bound to a program, the same handle can be used with every Shader
+ * declaring the uniform, e.g.
+ * @code
+ * constexpr Uniform<glm::vec3> lightPosition{ "light.position" };
+ * shader->set(lightPosition, position);
+ * @endcode
+ */
+template <typename T>
+struct Uniform {
+    constexpr explicit Uniform(std::string_view name) : name(name), hash(fnv1a(name)) {}
+
+    std::string_view name;
+    uint64_t hash;
+};
+
+/**
+ * @brief Description of an active uniform, as reported by the driver after linking
+ */
+struct UniformInfo {
+    std::string name;
+    GLint location;
+    GLenum type;
+    GLint size;
+};
+
+/**
+ * @brief Flat open addressing table mapping a uniform name hash to its location
+ *
+ * The table is filled once after a program is linked, lookups never call the driver
+ * and never allocate.
+ */
+class UniformTable
+{
+public:
+    /**
+     * @brief Empty the table, needed before a program is linked again
+     */
+    void clear();
+
+    /**
+     * @brief Register an active uniform
+     *
+     * @return false if another uniform with the same hash is already registered
+     */
+    bool insert(const UniformInfo &info);
+
+    /**
+     * @brief Register another name for an already inserted uniform, e.g. "lights" for "lights[0]"
+     *
+     * @param index The index of the uniform in @ref getUniforms
+     * @return false if another uniform with the same hash is already registered
+     */
+    bool alias(const std::string &name, int index);
+
+    /**
+     * @brief Find the index of the uniform in @ref getUniforms
+     *
+     * @param hash The FNV-1a hash of the uniform name
+     * @return int -1 if the uniform is not active in the program
+     */
+    int find(uint64_t hash) const;
+
+    const std::vector<UniformInfo> &getUniforms() const {
+        return m_uniforms;
+    }
+
+private:
+    struct Slot {
+        uint64_t hash = 0;
+        int index = -1;
+    };
+
+    std::vector<Slot> m_slots;
+    std::vector<UniformInfo> m_uniforms;
+
+    size_t m_used = 0;
+
+    void place(uint64_t hash, int index);
+    void grow();
+};
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "glad/glad.h"
+
+#include "shader.hpp"
+#include "vertex_format.hpp"
+
+#include <cstdint>
+#include <unordered_map>
+
+/**
+ * @brief Builds vertex arrays by matching the semantics of a vertex format with the inputs of a program
+ *
+ * Vertex arrays are cached per (vertex format, program interface, buffers), so drawing the same
+ * buffers with any program having the same inputs reuses the same vertex array.
+ */
+class VertexArrayCache
+{
+public:
+    /**
+     * @brief Get the vertex array feeding the buffers to the program, built on first use
+     *
+     * Every input of the program is bound at its reflected location to the attribute of
+     * the format having the same semantic. The build fails if an input has an unknown name
+     * or if the format doesn't provide it.
+     *
+     * @param format The layout of the vertex buffer
+     * @param vertexBuffer The vertex buffer
+     * @param indexBuffer The index buffer, 0 for non indexed geometry
+     * @param shader A ready shader
+     * @return GLuint 0 if the format and the program don't match
+     */
+    static GLuint get(const VertexFormat &format, GLuint vertexBuffer, GLuint indexBuffer, const Shader &shader);
+
+    /**
+     * @brief Delete every cached vertex array using the buffer, to call before deleting the buffer
+     */
+    static void release(GLuint buffer);
+
+private:
+    struct Entry {
+        GLuint vao;
+        GLuint vertexBuffer;
+        GLuint indexBuffer;
+    };
+
+    static GLuint build(const VertexFormat &format, GLuint vertexBuffer, GLuint indexBuffer, const Shader &shader);
+
+    inline static std::unordered_map<uint64_t, Entry> s_cache;
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "glad/glad.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Meaning of a vertex attribute, used to match buffers with shader inputs
+ * instead of relying on both sides agreeing on layout locations
+ */
+enum class VertexSemantic {
+    POSITION,
+    NORMAL,
+    TEXCOORD,
+    TANGENT,
+    COLOR
+};
+
+/**
+ * @brief Find the semantic of a shader input from its name, e.g. "aPos" or "aTexCoords"
+ *
+ * @return false if the name isn't a known semantic
+ */
+bool semanticFromName(const std::string &name, VertexSemantic &semantic);
+
+const char *semanticName(VertexSemantic semantic);
+
+/**
+ * @brief One attribute inside an interleaved vertex buffer
+ */
+struct VertexAttribute {
+    VertexSemantic semantic;
+    GLint components;
+    GLenum type;
+    GLboolean normalized;
+    GLuint offset;
+};
+
+/**
+ * @brief Layout of an interleaved vertex buffer
+ */
+struct VertexFormat {
+    std::vector<VertexAttribute> attributes;
+    GLsizei stride = 0;
+
+    /**
+     * @brief Find the attribute having the semantic
+     *
+     * @return const VertexAttribute* nullptr if the format doesn't provide it
+     */
+    const VertexAttribute *find(VertexSemantic semantic) const;
+
+    /**
+     * @brief Hash of the whole layout, two formats with the same hash are interchangeable
+     */
+    uint64_t hash() const;
+};
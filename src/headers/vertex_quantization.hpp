@@ -0,0 +1,99 @@
+#pragma once
+
+#include "glad/glad.h"
+#include <glm/glm.hpp>
+
+#include "mesh_data.hpp"
+#include "vertex_format.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Compact vertex layouts, 16 bytes instead of the 32 of MeshVertex
+ *
+ * Positions are unorm16 relative to the bounds of the mesh, decoded by folding @ref Decode::positionTransform into the model matrix.
+ * Normals are octahedral snorm16 pairs decoded by the vertex shader, see COMPACT_VERTEX in light.vs.
+ * Texture coordinates are half floats or unorm16 relative to the range the mesh uses, decoded with @ref Decode::texCoordTransform.
+ *
+ * @note Can be called from any thread, never touches OpenGL
+ */
+class VertexQuantization
+{
+public:
+    /**
+     * @brief Ranges the attributes were quantized in, needed to decode them
+     */
+    struct Decode {
+        glm::vec3 positionOffset = glm::vec3(0.0f);
+        glm::vec3 positionScale = glm::vec3(1.0f);
+        glm::vec2 texCoordOffset = glm::vec2(0.0f);
+        glm::vec2 texCoordScale = glm::vec2(1.0f);
+
+        /**
+         * @brief Matrix turning the normalized positions back into model space
+         */
+        glm::mat4 positionTransform() const;
+
+        /**
+         * @brief Offset in xy and scale in zw applied to the texture coordinates by the shader
+         */
+        glm::vec4 texCoordTransform() const {
+            return glm::vec4(texCoordOffset, texCoordScale);
+        }
+    };
+
+    /**
+     * @brief Largest differences between the decoded vertices and the float ones
+     */
+    struct Error {
+        // Largest distance on an axis, in model space
+        float position = 0.0f;
+        // Largest angle between the normals, in degrees
+        float normal = 0.0f;
+        // Largest difference on an axis
+        float texCoord = 0.0f;
+    };
+
+    static size_t stride(VertexLayout layout);
+
+    /**
+     * @brief Get the attributes of a layout, normalized formats for the compact ones
+     */
+    static VertexFormat format(VertexLayout layout);
+
+    /**
+     * @brief Compute the ranges covering every vertex
+     */
+    static Decode computeDecode(const std::vector<MeshVertex> &vertices, VertexLayout layout);
+
+    /**
+     * @brief Quantize the vertices into the layout, FLOAT copies them as they are
+     */
+    static std::vector<uint8_t> encode(const std::vector<MeshVertex> &vertices, VertexLayout layout, const Decode &decode);
+
+    /**
+     * @brief Decode a vertex the way the shaders do, the float reference of the compact layouts
+     */
+    static MeshVertex decode(const uint8_t *vertex, VertexLayout layout, const Decode &decode);
+
+    /**
+     * @brief Decode every vertex and measure how far it lands from its float version
+     */
+    static Error measure(const std::vector<MeshVertex> &vertices, const std::vector<uint8_t> &encoded, VertexLayout layout, const Decode &decode);
+
+    /**
+     * @brief Get the largest error rounding to nearest can produce with a layout and ranges
+     *
+     * Positions and unorm texture coordinates are off by half a step at most, octahedral normals by 0.01 degrees,
+     * half floats by half of their precision at the largest coordinate of the mesh.
+     */
+    static Error bounds(VertexLayout layout, const Decode &decode, const std::vector<MeshVertex> &vertices);
+
+    /**
+     * @brief Map a unit vector on the octahedron unfolded in [-1, 1]^2
+     */
+    static glm::vec2 octahedralEncode(const glm::vec3 &normal);
+    static glm::vec3 octahedralDecode(const glm::vec2 &encoded);
+};
@@ -0,0 +1,49 @@
+#include "headers/mapped_file.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#endif
+
+MappedFile::MappedFile(const std::string& path) {
+#if defined(__unix__) || defined(__APPLE__)
+    int descriptor = open(path.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        return;
+    }
+
+    struct stat status;
+    if (fstat(descriptor, &status) == 0 && status.st_size > 0) {
+        void* mapping = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if (mapping != MAP_FAILED) {
+            m_data = static_cast<const unsigned char*>(mapping);
+            m_size = static_cast<size_t>(status.st_size);
+        }
+    }
+    // The mapping stays valid once the descriptor is closed
+    close(descriptor);
+#else
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        return;
+    }
+    m_fallback.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    if (!m_fallback.empty() && file.read(reinterpret_cast<char*>(m_fallback.data()), m_fallback.size())) {
+        m_data = m_fallback.data();
+        m_size = m_fallback.size();
+    }
+#endif
+}
+
+MappedFile::~MappedFile() {
+#if defined(__unix__) || defined(__APPLE__)
+    if (m_data != nullptr) {
+        munmap(const_cast<unsigned char*>(m_data), m_size);
+    }
+#endif
+}
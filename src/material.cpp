@@ -20,6 +20,16 @@ Material* Material::withShininess(float shininess) {
     return this;
 }
 
+Material* Material::withDiffuseMap(const AtlasRegion& region) {
+    this->diffuseMap = region;
+    return this;
+}
+
+Material* Material::withSpecularMap(const AtlasRegion& region) {
+    this->specularMap = region;
+    return this;
+}
+
 glm::vec3 Material::getAmbient() {
     return ambient;
 }
@@ -32,6 +42,14 @@ glm::vec3 Material::getSpecular() {
     return specular;
 }
 
+const AtlasRegion& Material::getDiffuseMap() {
+    return diffuseMap;
+}
+
+const AtlasRegion& Material::getSpecularMap() {
+    return specularMap;
+}
+
 float Material::getRealShininess() {
     return shininess;
 }
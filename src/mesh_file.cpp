@@ -0,0 +1,315 @@
+#include "headers/mesh_file.hpp"
+#include "headers/cooked_path.hpp"
+#include "headers/mesh_processing.hpp"
+#include "headers/logger.hpp"
+
+#include <bit>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+// Sections are written as they are in memory and mapped back without any conversion
+static_assert(std::endian::native == std::endian::little, "Cooked meshes are little endian");
+
+namespace {
+    // "AEMS"
+    constexpr uint32_t MAGIC = 0x534d4541;
+    constexpr size_t SECTION_ALIGNMENT = 16;
+
+    struct SubmeshRecord {
+        uint32_t firstIndex;
+        uint32_t indexCount;
+        uint32_t material;
+        uint32_t reserved;
+        float min[3];
+        float max[3];
+    };
+
+    struct MaterialRecord {
+        uint32_t diffuseOffset;
+        uint32_t diffuseLength;
+        uint32_t specularOffset;
+        uint32_t specularLength;
+    };
+
+    size_t align(size_t offset) {
+        return (offset + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+    }
+}
+
+struct MeshFile::Header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vertexLayout;
+    uint32_t vertexStride;
+    uint32_t vertexCount;
+    uint32_t indexSize;
+    uint32_t indexCount;
+    uint32_t submeshCount;
+    uint32_t materialCount;
+    uint32_t stringBytes;
+    float boundsMin[3];
+    float boundsMax[3];
+    // Ranges of the compact layouts, see VertexQuantization::Decode
+    float positionOffset[3];
+    float positionScale[3];
+    float texCoordOffset[2];
+    float texCoordScale[2];
+    uint64_t vertexOffset;
+    uint64_t indexOffset;
+    uint64_t submeshOffset;
+    uint64_t materialOffset;
+    uint64_t stringOffset;
+};
+
+std::string MeshFile::cookedPath(const std::string& filename) {
+    return ::cookedPath(filename, ".mesh");
+}
+
+bool MeshFile::isCooked(const std::string& filename) {
+    std::error_code error;
+    auto cooked = std::filesystem::last_write_time(cookedPath(filename), error);
+    if (error) {
+        return false;
+    }
+    auto original = std::filesystem::last_write_time(filename, error);
+    return !error && cooked >= original;
+}
+
+bool MeshFile::write(const std::string& filename, const MeshData& mesh, VertexLayout layout) {
+    VertexQuantization::Decode decode = VertexQuantization::computeDecode(mesh.vertices, layout);
+    std::vector<uint8_t> vertices = VertexQuantization::encode(mesh.vertices, layout, decode);
+
+    std::filesystem::path directory = std::filesystem::path(filename).parent_path();
+
+    // Paths relative to the cooked file, joined back with its directory by open
+    std::string strings;
+    std::vector<MaterialRecord> materials;
+    auto addString = [&strings, &directory](const std::string& path, uint32_t& offset, uint32_t& length) {
+        std::string relative = path.empty() ? std::string() : std::filesystem::path(path).lexically_relative(directory.empty() ? "." : directory).generic_string();
+        offset = static_cast<uint32_t>(strings.size());
+        length = static_cast<uint32_t>(relative.size());
+        strings += relative;
+    };
+    for (const MeshMaterial& material : mesh.materials) {
+        MaterialRecord record{};
+        addString(material.diffuse, record.diffuseOffset, record.diffuseLength);
+        addString(material.specular, record.specularOffset, record.specularLength);
+        materials.push_back(record);
+    }
+
+    std::vector<SubmeshRecord> submeshes;
+    for (const Submesh& submesh : mesh.submeshes) {
+        SubmeshRecord record{};
+        record.firstIndex = submesh.firstIndex;
+        record.indexCount = submesh.indexCount;
+        record.material = submesh.material;
+        std::memcpy(record.min, &submesh.bounds.min[0], sizeof(record.min));
+        std::memcpy(record.max, &submesh.bounds.max[0], sizeof(record.max));
+        submeshes.push_back(record);
+    }
+
+    GLenum indexType = MeshProcessing::indexType(mesh.vertices.size());
+    std::vector<uint8_t> indices = MeshProcessing::packIndices(mesh.indices, indexType);
+
+    static_assert(sizeof(Header) % SECTION_ALIGNMENT == 0, "The first section must stay aligned");
+    Header header{};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.vertexLayout = static_cast<uint32_t>(layout);
+    header.vertexStride = static_cast<uint32_t>(VertexQuantization::stride(layout));
+    header.vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+    header.indexSize = static_cast<uint32_t>(MeshProcessing::indexSize(indexType));
+    header.indexCount = static_cast<uint32_t>(mesh.indices.size());
+    header.submeshCount = static_cast<uint32_t>(submeshes.size());
+    header.materialCount = static_cast<uint32_t>(materials.size());
+    header.stringBytes = static_cast<uint32_t>(strings.size());
+    std::memcpy(header.boundsMin, &mesh.bounds.min[0], sizeof(header.boundsMin));
+    std::memcpy(header.boundsMax, &mesh.bounds.max[0], sizeof(header.boundsMax));
+    std::memcpy(header.positionOffset, &decode.positionOffset[0], sizeof(header.positionOffset));
+    std::memcpy(header.positionScale, &decode.positionScale[0], sizeof(header.positionScale));
+    std::memcpy(header.texCoordOffset, &decode.texCoordOffset[0], sizeof(header.texCoordOffset));
+    std::memcpy(header.texCoordScale, &decode.texCoordScale[0], sizeof(header.texCoordScale));
+
+    // Every section lists its bytes and where it starts, written in the order of the header
+    struct Section {
+        const void* data;
+        size_t size;
+        uint64_t* offset;
+    };
+    const Section sections[] = {
+        { vertices.data(), vertices.size(), &header.vertexOffset },
+        { indices.data(), indices.size(), &header.indexOffset },
+        { submeshes.data(), submeshes.size() * sizeof(SubmeshRecord), &header.submeshOffset },
+        { materials.data(), materials.size() * sizeof(MaterialRecord), &header.materialOffset },
+        { strings.data(), strings.size(), &header.stringOffset },
+    };
+    size_t offset = sizeof(Header);
+    for (const Section& section : sections) {
+        offset = align(offset);
+        *section.offset = offset;
+        offset += section.size;
+    }
+
+    std::error_code directoryError;
+    std::filesystem::create_directories(directory, directoryError);
+
+    std::string temporary = filename + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            logger.error("Cannot write mesh " + filename);
+            return false;
+        }
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        size_t written = sizeof(header);
+        const char padding[SECTION_ALIGNMENT] = {};
+        for (const Section& section : sections) {
+            file.write(padding, static_cast<std::streamsize>(*section.offset - written));
+            file.write(static_cast<const char*>(section.data), static_cast<std::streamsize>(section.size));
+            written = *section.offset + section.size;
+        }
+        if (!file) {
+            logger.error("Cannot write mesh " + filename);
+            file.close();
+            std::error_code error;
+            std::filesystem::remove(temporary, error);
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporary, filename, error);
+    if (error) {
+        logger.error("Cannot write mesh " + filename);
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+    return true;
+}
+
+bool MeshFile::open(const std::string& filename) {
+    m_header = nullptr;
+    m_file = std::make_unique<MappedFile>(filename);
+    if (!m_file->isOpen() || m_file->size() < sizeof(Header)) {
+        return false;
+    }
+
+    const Header* header = reinterpret_cast<const Header*>(m_file->data());
+    if (header->magic != MAGIC || header->version != VERSION) {
+        logger.warn("Mesh " + filename + " was cooked by another version");
+        return false;
+    }
+    if (header->vertexLayout > static_cast<uint32_t>(VertexLayout::COMPACT_UNORM_UV)
+        || header->vertexStride != VertexQuantization::stride(static_cast<VertexLayout>(header->vertexLayout))
+        || (header->indexSize != sizeof(uint16_t) && header->indexSize != sizeof(uint32_t))) {
+        logger.error("Mesh " + filename + " has an unknown vertex or index format");
+        return false;
+    }
+
+    // Only the bounds of the sections are checked, the streams themselves go to the driver untouched
+    auto fits = [this](uint64_t offset, uint64_t bytes) {
+        return offset % SECTION_ALIGNMENT == 0 && offset <= m_file->size() && bytes <= m_file->size() - offset;
+    };
+    if (!fits(header->vertexOffset, static_cast<uint64_t>(header->vertexCount) * header->vertexStride)
+        || !fits(header->indexOffset, static_cast<uint64_t>(header->indexCount) * header->indexSize)
+        || !fits(header->submeshOffset, static_cast<uint64_t>(header->submeshCount) * sizeof(SubmeshRecord))
+        || !fits(header->materialOffset, static_cast<uint64_t>(header->materialCount) * sizeof(MaterialRecord))
+        || !fits(header->stringOffset, header->stringBytes)) {
+        logger.error("Mesh " + filename + " is truncated");
+        return false;
+    }
+
+    const SubmeshRecord* submeshes = reinterpret_cast<const SubmeshRecord*>(m_file->data() + header->submeshOffset);
+    for (uint32_t i = 0; i < header->submeshCount; i++) {
+        if (static_cast<uint64_t>(submeshes[i].firstIndex) + submeshes[i].indexCount > header->indexCount) {
+            logger.error("Mesh " + filename + " has a submesh outside of its index buffer");
+            return false;
+        }
+    }
+    const MaterialRecord* materials = reinterpret_cast<const MaterialRecord*>(m_file->data() + header->materialOffset);
+    for (uint32_t i = 0; i < header->materialCount; i++) {
+        if (static_cast<uint64_t>(materials[i].diffuseOffset) + materials[i].diffuseLength > header->stringBytes
+            || static_cast<uint64_t>(materials[i].specularOffset) + materials[i].specularLength > header->stringBytes) {
+            logger.error("Mesh " + filename + " has a material outside of its strings");
+            return false;
+        }
+    }
+
+    m_header = header;
+    m_directory = std::filesystem::path(filename).parent_path().generic_string();
+    return true;
+}
+
+const void* MeshFile::getVertices() const {
+    return m_file->data() + m_header->vertexOffset;
+}
+
+size_t MeshFile::getVertexBytes() const {
+    return static_cast<size_t>(m_header->vertexCount) * m_header->vertexStride;
+}
+
+VertexLayout MeshFile::getVertexLayout() const {
+    return static_cast<VertexLayout>(m_header->vertexLayout);
+}
+
+VertexQuantization::Decode MeshFile::getDecode() const {
+    VertexQuantization::Decode decode;
+    decode.positionOffset = glm::vec3(m_header->positionOffset[0], m_header->positionOffset[1], m_header->positionOffset[2]);
+    decode.positionScale = glm::vec3(m_header->positionScale[0], m_header->positionScale[1], m_header->positionScale[2]);
+    decode.texCoordOffset = glm::vec2(m_header->texCoordOffset[0], m_header->texCoordOffset[1]);
+    decode.texCoordScale = glm::vec2(m_header->texCoordScale[0], m_header->texCoordScale[1]);
+    return decode;
+}
+
+const void* MeshFile::getIndices() const {
+    return m_file->data() + m_header->indexOffset;
+}
+
+size_t MeshFile::getIndexBytes() const {
+    return static_cast<size_t>(m_header->indexCount) * m_header->indexSize;
+}
+
+GLenum MeshFile::getIndexType() const {
+    return m_header->indexSize == sizeof(uint16_t) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
+std::vector<Submesh> MeshFile::getSubmeshes() const {
+    const SubmeshRecord* records = reinterpret_cast<const SubmeshRecord*>(m_file->data() + m_header->submeshOffset);
+    std::vector<Submesh> submeshes;
+    for (uint32_t i = 0; i < m_header->submeshCount; i++) {
+        Submesh submesh;
+        submesh.firstIndex = records[i].firstIndex;
+        submesh.indexCount = records[i].indexCount;
+        submesh.material = records[i].material;
+        submesh.bounds.min = glm::vec3(records[i].min[0], records[i].min[1], records[i].min[2]);
+        submesh.bounds.max = glm::vec3(records[i].max[0], records[i].max[1], records[i].max[2]);
+        submeshes.push_back(submesh);
+    }
+    return submeshes;
+}
+
+std::vector<MeshMaterial> MeshFile::getMaterials() const {
+    const MaterialRecord* records = reinterpret_cast<const MaterialRecord*>(m_file->data() + m_header->materialOffset);
+    const char* strings = reinterpret_cast<const char*>(m_file->data() + m_header->stringOffset);
+    auto resolve = [this, strings](uint32_t offset, uint32_t length) {
+        if (length == 0) {
+            return std::string();
+        }
+        return (std::filesystem::path(m_directory) / std::string(strings + offset, length)).lexically_normal().generic_string();
+    };
+
+    std::vector<MeshMaterial> materials;
+    for (uint32_t i = 0; i < m_header->materialCount; i++) {
+        materials.push_back({ resolve(records[i].diffuseOffset, records[i].diffuseLength), resolve(records[i].specularOffset, records[i].specularLength) });
+    }
+    return materials;
+}
+
+MeshBounds MeshFile::getBounds() const {
+    MeshBounds bounds;
+    bounds.min = glm::vec3(m_header->boundsMin[0], m_header->boundsMin[1], m_header->boundsMin[2]);
+    bounds.max = glm::vec3(m_header->boundsMax[0], m_header->boundsMax[1], m_header->boundsMax[2]);
+    return bounds;
+}
@@ -0,0 +1,447 @@
+#include "headers/mesh_processing.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+
+namespace {
+    constexpr size_t VERTEX_WORDS = sizeof(MeshVertex) / sizeof(uint32_t);
+    constexpr uint32_t EMPTY = UINT32_MAX;
+
+    /**
+     * @brief The bits of every attribute, negative zeros folded into zeros so they hash and compare the same
+     */
+    struct VertexKey {
+        uint32_t words[VERTEX_WORDS];
+
+        explicit VertexKey(const MeshVertex& vertex) {
+            std::memcpy(words, &vertex, sizeof(MeshVertex));
+            for (uint32_t& word : words) {
+                word = word == 0x80000000u ? 0 : word;
+            }
+        }
+
+        bool operator==(const VertexKey& other) const {
+            return std::memcmp(words, other.words, sizeof(words)) == 0;
+        }
+
+        uint32_t hash() const {
+            // Murmur3 mixing of every word, positions alone already spread well on real meshes
+            uint32_t h = 0;
+            for (uint32_t word : words) {
+                word *= 0xcc9e2d51u;
+                word = std::rotl(word, 15) * 0x1b873593u;
+                h = std::rotl(h ^ word, 13) * 5 + 0xe6546b64u;
+            }
+            h ^= h >> 16;
+            h *= 0x85ebca6bu;
+            h ^= h >> 13;
+            h *= 0xc2b2ae35u;
+            return h ^ (h >> 16);
+        }
+    };
+
+    /**
+     * @brief FIFO post transform cache, a vertex stays cached until as many misses as the cache holds happened after its own
+     */
+    class FifoCache {
+    public:
+        FifoCache(size_t vertexCount, size_t size) : m_stamps(vertexCount, 0), m_time(size), m_size(size) {}
+
+        /**
+         * @brief Returns true if the vertex had to be transformed
+         */
+        bool access(uint32_t vertex) {
+            if (m_time - m_stamps[vertex] < m_size) {
+                return false;
+            }
+            m_stamps[vertex] = ++m_time;
+            return true;
+        }
+
+        void flush() {
+            m_time += m_size;
+        }
+
+    private:
+        std::vector<size_t> m_stamps;
+        size_t m_time;
+        size_t m_size;
+    };
+
+    size_t countMisses(const uint32_t* indices, size_t count, FifoCache& cache) {
+        size_t misses = 0;
+        for (size_t i = 0; i < count; i++) {
+            misses += cache.access(indices[i]) ? 1 : 0;
+        }
+        return misses;
+    }
+
+    /**
+     * @brief Run a pass on the triangles of each submesh with indices local to the submesh, from 0 to the number of vertices it uses
+     *
+     * @param pass Called with the local indices, to reorder in place, and the index in the mesh of each local vertex
+     */
+    template <typename Pass>
+    void forEachSubmesh(MeshData& mesh, Pass pass) {
+        std::vector<uint32_t> localOf(mesh.vertices.size(), EMPTY);
+        std::vector<uint32_t> local;
+        std::vector<uint32_t> globalOf;
+        for (const Submesh& submesh : mesh.submeshes) {
+            uint32_t* indices = mesh.indices.data() + submesh.firstIndex;
+            size_t count = submesh.indexCount / 3 * 3;
+            local.clear();
+            globalOf.clear();
+            for (size_t i = 0; i < count; i++) {
+                if (localOf[indices[i]] == EMPTY) {
+                    localOf[indices[i]] = static_cast<uint32_t>(globalOf.size());
+                    globalOf.push_back(indices[i]);
+                }
+                local.push_back(localOf[indices[i]]);
+            }
+
+            pass(local, globalOf);
+
+            for (size_t i = 0; i < count; i++) {
+                indices[i] = globalOf[local[i]];
+            }
+            for (uint32_t vertex : globalOf) {
+                localOf[vertex] = EMPTY;
+            }
+        }
+    }
+
+    // Tuning of Forsyth's "Linear-Speed Vertex Cache Optimisation", the scored cache is larger than the simulated one on purpose
+    constexpr size_t SCORED_CACHE_SIZE = 32;
+    constexpr float CACHE_DECAY_POWER = 1.5f;
+    constexpr float LAST_TRIANGLE_SCORE = 0.75f;
+    constexpr float VALENCE_BOOST_SCALE = 2.0f;
+    constexpr float VALENCE_BOOST_POWER = 0.5f;
+
+    float vertexScore(int cachePosition, uint32_t remaining) {
+        if (remaining == 0) {
+            return -1.0f;
+        }
+        float score = 0.0f;
+        if (cachePosition >= 0) {
+            // The vertices of the last triangle get a fixed score, using them again right away barely helps
+            score = cachePosition < 3 ? LAST_TRIANGLE_SCORE
+                                      : std::pow(1.0f - static_cast<float>(cachePosition - 3) / (SCORED_CACHE_SIZE - 3), CACHE_DECAY_POWER);
+        }
+        // Vertices with few triangles left are finished first so they leave the cache for good
+        return score + VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remaining), -VALENCE_BOOST_POWER);
+    }
+
+    void forsyth(std::vector<uint32_t>& indices, size_t vertexCount) {
+        size_t triangleCount = indices.size() / 3;
+        if (triangleCount < 2) {
+            return;
+        }
+
+        // Triangles left of each vertex, packed in one array
+        std::vector<uint32_t> remaining(vertexCount, 0);
+        for (uint32_t index : indices) {
+            remaining[index]++;
+        }
+        std::vector<uint32_t> offsets(vertexCount + 1, 0);
+        for (size_t v = 0; v < vertexCount; v++) {
+            offsets[v + 1] = offsets[v] + remaining[v];
+        }
+        std::vector<uint32_t> adjacency(indices.size());
+        std::vector<uint32_t> filled(offsets.begin(), offsets.end() - 1);
+        for (size_t t = 0; t < triangleCount; t++) {
+            for (size_t k = 0; k < 3; k++) {
+                adjacency[filled[indices[t * 3 + k]]++] = static_cast<uint32_t>(t);
+            }
+        }
+
+        std::vector<int> cachePosition(vertexCount, -1);
+        std::vector<float> score(vertexCount);
+        for (size_t v = 0; v < vertexCount; v++) {
+            score[v] = vertexScore(-1, remaining[v]);
+        }
+        std::vector<float> triangleScore(triangleCount);
+        std::vector<bool> emitted(triangleCount, false);
+        size_t best = 0;
+        for (size_t t = 0; t < triangleCount; t++) {
+            triangleScore[t] = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+            best = triangleScore[t] > triangleScore[best] ? t : best;
+        }
+
+        // Updates the score of a vertex and of the triangles it still has
+        auto rescore = [&](uint32_t vertex, int position) {
+            cachePosition[vertex] = position;
+            float updated = vertexScore(position, remaining[vertex]);
+            float delta = updated - score[vertex];
+            score[vertex] = updated;
+            for (uint32_t i = offsets[vertex]; i < offsets[vertex] + remaining[vertex]; i++) {
+                triangleScore[adjacency[i]] += delta;
+            }
+        };
+
+        std::vector<uint32_t> output;
+        output.reserve(indices.size());
+        std::vector<uint32_t> cache;
+        std::vector<uint32_t> nextCache;
+        size_t cursor = 0;
+        for (size_t emittedCount = 0; emittedCount < triangleCount; emittedCount++) {
+            // Dead end, none of the cached vertices has triangles left
+            if (best == SIZE_MAX) {
+                while (emitted[cursor]) {
+                    cursor++;
+                }
+                best = cursor;
+            }
+
+            const uint32_t triangle[3] = { indices[best * 3], indices[best * 3 + 1], indices[best * 3 + 2] };
+            output.insert(output.end(), triangle, triangle + 3);
+            emitted[best] = true;
+            for (uint32_t vertex : triangle) {
+                uint32_t* begin = adjacency.data() + offsets[vertex];
+                uint32_t* end = begin + remaining[vertex];
+                std::iter_swap(std::find(begin, end, static_cast<uint32_t>(best)), end - 1);
+                remaining[vertex]--;
+            }
+
+            // The vertices of the triangle move to the front, the ones pushed past the end leave the cache
+            nextCache.assign(triangle, triangle + 3);
+            for (uint32_t vertex : cache) {
+                if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2]) {
+                    nextCache.push_back(vertex);
+                }
+            }
+            for (size_t i = SCORED_CACHE_SIZE; i < nextCache.size(); i++) {
+                rescore(nextCache[i], -1);
+            }
+            nextCache.resize(std::min(nextCache.size(), SCORED_CACHE_SIZE));
+            std::swap(cache, nextCache);
+
+            // Only the triangles of cached vertices changed score, the next one is picked among them
+            for (size_t i = 0; i < cache.size(); i++) {
+                rescore(cache[i], static_cast<int>(i));
+            }
+            best = SIZE_MAX;
+            float bestScore = -1.0f;
+            for (uint32_t vertex : cache) {
+                for (uint32_t i = offsets[vertex]; i < offsets[vertex] + remaining[vertex]; i++) {
+                    if (triangleScore[adjacency[i]] > bestScore) {
+                        bestScore = triangleScore[adjacency[i]];
+                        best = adjacency[i];
+                    }
+                }
+            }
+        }
+        indices = std::move(output);
+    }
+
+    /**
+     * @brief Sort the clusters of a cache optimized triangle order by occlusion potential, after Sander et al. "Fast Triangle Reordering"
+     */
+    void sortClusters(std::vector<uint32_t>& indices, const std::vector<glm::vec3>& positions, float threshold) {
+        size_t triangleCount = indices.size() / 3;
+        if (triangleCount < 2) {
+            return;
+        }
+
+        // Clusters start where the cache misses every vertex, reordering them there costs almost no cache hit
+        FifoCache cache(positions.size(), MeshProcessing::CACHE_SIZE);
+        std::vector<size_t> starts;
+        for (size_t t = 0; t < triangleCount; t++) {
+            if (countMisses(indices.data() + t * 3, 3, cache) == 3 || t == 0) {
+                starts.push_back(t);
+            }
+        }
+        if (starts.size() < 2) {
+            return;
+        }
+        starts.push_back(triangleCount);
+
+        struct Cluster {
+            size_t first;
+            size_t count;
+            float occlusion;
+        };
+        std::vector<Cluster> clusters;
+        glm::vec3 center(0.0f);
+        float area = 0.0f;
+        std::vector<glm::vec3> centroids;
+        std::vector<glm::vec3> normals;
+        for (size_t c = 0; c + 1 < starts.size(); c++) {
+            glm::vec3 centroid(0.0f), normal(0.0f);
+            float clusterArea = 0.0f;
+            for (size_t t = starts[c]; t < starts[c + 1]; t++) {
+                const glm::vec3& a = positions[indices[t * 3]];
+                const glm::vec3& b = positions[indices[t * 3 + 1]];
+                const glm::vec3& d = positions[indices[t * 3 + 2]];
+                glm::vec3 cross = glm::cross(b - a, d - a);
+                float triangleArea = glm::length(cross);
+                centroid += (a + b + d) * (triangleArea / 3.0f);
+                normal += cross;
+                clusterArea += triangleArea;
+            }
+            center += centroid;
+            area += clusterArea;
+            centroids.push_back(clusterArea > 0.0f ? centroid / clusterArea : positions[indices[starts[c] * 3]]);
+            normals.push_back(normal);
+            clusters.push_back({ starts[c], starts[c + 1] - starts[c], 0.0f });
+        }
+        if (area <= 0.0f) {
+            return;
+        }
+        center /= area;
+
+        // Clusters facing away from the center are on the outside of the submesh and likely to hide the others
+        for (size_t c = 0; c < clusters.size(); c++) {
+            float length = glm::length(normals[c]);
+            clusters[c].occlusion = length > 0.0f ? glm::dot(centroids[c] - center, normals[c] / length) : 0.0f;
+        }
+        std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) { return a.occlusion > b.occlusion; });
+
+        std::vector<uint32_t> sorted;
+        sorted.reserve(indices.size());
+        for (const Cluster& cluster : clusters) {
+            sorted.insert(sorted.end(), indices.begin() + cluster.first * 3, indices.begin() + (cluster.first + cluster.count) * 3);
+        }
+
+        FifoCache before(positions.size(), MeshProcessing::CACHE_SIZE);
+        FifoCache after(positions.size(), MeshProcessing::CACHE_SIZE);
+        size_t missesBefore = countMisses(indices.data(), indices.size(), before);
+        size_t missesAfter = countMisses(sorted.data(), sorted.size(), after);
+        if (static_cast<float>(missesAfter) <= static_cast<float>(missesBefore) * threshold) {
+            indices = std::move(sorted);
+        }
+    }
+}
+
+static_assert(sizeof(MeshVertex) == VERTEX_WORDS * sizeof(uint32_t), "Vertices are hashed as 32 bits words");
+
+size_t MeshProcessing::weld(MeshData& mesh) {
+    std::vector<MeshVertex>& vertices = mesh.vertices;
+    size_t count = vertices.size();
+    if (count == 0) {
+        return 0;
+    }
+
+    // Open addressing over the kept vertices, at most half full so probes stay short
+    size_t capacity = std::bit_ceil(count * 2);
+    std::vector<uint32_t> table(capacity, EMPTY);
+    std::vector<uint32_t> remap(count);
+
+    // Vertices are compacted in place, a kept vertex never moves past the one being looked up
+    uint32_t kept = 0;
+    for (size_t i = 0; i < count; i++) {
+        VertexKey key(vertices[i]);
+        size_t slot = key.hash() & (capacity - 1);
+        while (table[slot] != EMPTY && !(VertexKey(vertices[table[slot]]) == key)) {
+            slot = (slot + 1) & (capacity - 1);
+        }
+        if (table[slot] == EMPTY) {
+            table[slot] = kept;
+            vertices[kept] = vertices[i];
+            kept++;
+        }
+        remap[i] = table[slot];
+    }
+
+    for (uint32_t& index : mesh.indices) {
+        index = remap[index];
+    }
+    vertices.resize(kept);
+    vertices.shrink_to_fit();
+    return count - kept;
+}
+
+MeshProcessing::CacheStats MeshProcessing::analyzeVertexCache(const MeshData& mesh, size_t cacheSize) {
+    CacheStats stats;
+    FifoCache cache(mesh.vertices.size(), cacheSize);
+    size_t misses = 0, triangles = 0;
+    for (const Submesh& submesh : mesh.submeshes) {
+        cache.flush();
+        misses += countMisses(mesh.indices.data() + submesh.firstIndex, submesh.indexCount, cache);
+        triangles += submesh.indexCount / 3;
+    }
+    if (triangles > 0) {
+        stats.acmr = static_cast<float>(misses) / static_cast<float>(triangles);
+        stats.atvr = static_cast<float>(misses) / static_cast<float>(mesh.vertices.size());
+    }
+    return stats;
+}
+
+void MeshProcessing::optimizeVertexCache(MeshData& mesh) {
+    forEachSubmesh(mesh, [](std::vector<uint32_t>& indices, const std::vector<uint32_t>& vertices) { forsyth(indices, vertices.size()); });
+}
+
+void MeshProcessing::optimizeOverdraw(MeshData& mesh, float threshold) {
+    std::vector<glm::vec3> positions;
+    forEachSubmesh(mesh, [&mesh, &positions, threshold](std::vector<uint32_t>& indices, const std::vector<uint32_t>& vertices) {
+        positions.clear();
+        for (uint32_t vertex : vertices) {
+            positions.push_back(mesh.vertices[vertex].position);
+        }
+        sortClusters(indices, positions, threshold);
+    });
+}
+
+void MeshProcessing::optimizeVertexFetch(MeshData& mesh) {
+    std::vector<uint32_t> remap(mesh.vertices.size(), EMPTY);
+    std::vector<MeshVertex> vertices;
+    vertices.reserve(mesh.vertices.size());
+    for (uint32_t& index : mesh.indices) {
+        if (remap[index] == EMPTY) {
+            remap[index] = static_cast<uint32_t>(vertices.size());
+            vertices.push_back(mesh.vertices[index]);
+        }
+        index = remap[index];
+    }
+    mesh.vertices = std::move(vertices);
+}
+
+MeshProcessing::OptimizeStats MeshProcessing::optimize(MeshData& mesh) {
+    OptimizeStats stats;
+    stats.before = analyzeVertexCache(mesh);
+    optimizeVertexCache(mesh);
+    optimizeOverdraw(mesh);
+    optimizeVertexFetch(mesh);
+    stats.after = analyzeVertexCache(mesh);
+    return stats;
+}
+
+MeshData MeshProcessing::fromTriangles(const MeshVertex* vertices, size_t count) {
+    MeshData mesh;
+    mesh.vertices.assign(vertices, vertices + count);
+    mesh.indices.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        mesh.indices[i] = static_cast<uint32_t>(i);
+        mesh.bounds.extend(vertices[i].position);
+    }
+
+    Submesh submesh;
+    submesh.indexCount = static_cast<uint32_t>(count);
+    submesh.bounds = mesh.bounds;
+    mesh.submeshes.push_back(submesh);
+
+    weld(mesh);
+    return mesh;
+}
+
+GLenum MeshProcessing::indexType(size_t vertexCount) {
+    return vertexCount <= 65536 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
+size_t MeshProcessing::indexSize(GLenum type) {
+    return type == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+}
+
+std::vector<uint8_t> MeshProcessing::packIndices(const std::vector<uint32_t>& indices, GLenum type) {
+    std::vector<uint8_t> packed(indices.size() * indexSize(type));
+    if (type == GL_UNSIGNED_SHORT) {
+        uint16_t* narrow = reinterpret_cast<uint16_t*>(packed.data());
+        for (size_t i = 0; i < indices.size(); i++) {
+            narrow[i] = static_cast<uint16_t>(indices[i]);
+        }
+    } else {
+        std::memcpy(packed.data(), indices.data(), packed.size());
+    }
+    return packed;
+}
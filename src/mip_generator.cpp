@@ -0,0 +1,296 @@
+#include "headers/mip_generator.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define MIP_GENERATOR_SSE2
+#endif
+
+namespace {
+    constexpr float PI = 3.14159265358979f;
+    // Radius of the windowed sinc filters, in texels of the smaller level
+    constexpr float SINC_RADIUS = 2.0f;
+    constexpr float KAISER_ALPHA = 4.0f;
+
+    /**
+     * @brief Taps of a separable filter along one axis, every destination texel has the same number of taps
+     */
+    struct Kernel {
+        int taps = 0;
+        std::vector<int> indices;
+        std::vector<float> weights;
+    };
+
+    float sinc(float x) {
+        return std::abs(x) < 1e-5f ? 1.0f : std::sin(PI * x) / (PI * x);
+    }
+
+    // Modified Bessel function of the first kind, for the Kaiser window
+    float bessel0(float x) {
+        float sum = 1.0f, term = 1.0f;
+        for (int k = 1; k < 16; k++) {
+            term *= (x / (2.0f * k)) * (x / (2.0f * k));
+            sum += term;
+        }
+        return sum;
+    }
+
+    float radius(MipGenerator::Filter filter) {
+        return filter == MipGenerator::Filter::BOX ? 0.5f : SINC_RADIUS;
+    }
+
+    float weight(MipGenerator::Filter filter, float x) {
+        switch (filter) {
+        case MipGenerator::Filter::BOX:
+            return std::abs(x) <= 0.5f ? 1.0f : 0.0f;
+        case MipGenerator::Filter::LANCZOS:
+            return std::abs(x) < SINC_RADIUS ? sinc(x) * sinc(x / SINC_RADIUS) : 0.0f;
+        case MipGenerator::Filter::KAISER: {
+            float t = x / SINC_RADIUS;
+            return std::abs(t) < 1.0f ? sinc(x) * bessel0(KAISER_ALPHA * std::sqrt(1.0f - t * t)) / bessel0(KAISER_ALPHA) : 0.0f;
+        }
+        }
+        return 0.0f;
+    }
+
+    Kernel buildKernel(int source, int destination, const MipGenerator::Options& options) {
+        float scale = static_cast<float>(source) / static_cast<float>(destination);
+        float support = radius(options.filter) * scale;
+
+        Kernel kernel;
+        kernel.taps = static_cast<int>(std::ceil(2.0f * support)) + 1;
+        kernel.indices.resize(static_cast<size_t>(destination) * kernel.taps);
+        kernel.weights.resize(static_cast<size_t>(destination) * kernel.taps);
+
+        for (int x = 0; x < destination; x++) {
+            float center = (x + 0.5f) * scale;
+            int first = static_cast<int>(std::floor(center - support));
+            float sum = 0.0f;
+            for (int k = 0; k < kernel.taps; k++) {
+                int i = first + k;
+                // Distance between the centers, in texels of the smaller level
+                float w = weight(options.filter, (i + 0.5f - center) / scale);
+                if (options.wrap) {
+                    i = ((i % source) + source) % source;
+                } else {
+                    i = std::clamp(i, 0, source - 1);
+                }
+                kernel.indices[x * kernel.taps + k] = i;
+                kernel.weights[x * kernel.taps + k] = w;
+                sum += w;
+            }
+            for (int k = 0; k < kernel.taps; k++) {
+                kernel.weights[x * kernel.taps + k] /= sum;
+            }
+        }
+        return kernel;
+    }
+
+    /**
+     * @brief Filter the rows of a RGBA float image, every texel is a single SIMD register
+     */
+    void filterRows(const float* source, int sourceWidth, int height, const Kernel& kernel, int width, float* destination) {
+        for (int y = 0; y < height; y++) {
+            const float* row = source + static_cast<size_t>(y) * sourceWidth * 4;
+            float* out = destination + static_cast<size_t>(y) * width * 4;
+            int x = 0;
+#if defined(__AVX2__)
+            // Two texels at once, one per lane
+            for (; x + 1 < width; x += 2) {
+                const int* first = &kernel.indices[x * kernel.taps];
+                const int* second = first + kernel.taps;
+                const float* firstWeights = &kernel.weights[x * kernel.taps];
+                const float* secondWeights = firstWeights + kernel.taps;
+                __m256 sum = _mm256_setzero_ps();
+                for (int k = 0; k < kernel.taps; k++) {
+                    __m256 texels = _mm256_set_m128(_mm_loadu_ps(row + second[k] * 4), _mm_loadu_ps(row + first[k] * 4));
+                    __m256 weights = _mm256_set_m128(_mm_set1_ps(secondWeights[k]), _mm_set1_ps(firstWeights[k]));
+                    sum = _mm256_add_ps(sum, _mm256_mul_ps(texels, weights));
+                }
+                _mm256_storeu_ps(out + x * 4, sum);
+            }
+#endif
+            for (; x < width; x++) {
+                const int* indices = &kernel.indices[x * kernel.taps];
+                const float* weights = &kernel.weights[x * kernel.taps];
+#if defined(__AVX2__) || defined(MIP_GENERATOR_SSE2)
+                __m128 sum = _mm_setzero_ps();
+                for (int k = 0; k < kernel.taps; k++) {
+                    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(row + indices[k] * 4), _mm_set1_ps(weights[k])));
+                }
+                _mm_storeu_ps(out + x * 4, sum);
+#else
+                float sum[4] = {};
+                for (int k = 0; k < kernel.taps; k++) {
+                    for (int c = 0; c < 4; c++) {
+                        sum[c] += row[indices[k] * 4 + c] * weights[k];
+                    }
+                }
+                std::memcpy(out + x * 4, sum, sizeof(sum));
+#endif
+            }
+        }
+    }
+
+    /**
+     * @brief Filter the columns of a RGBA float image, whole rows are weighted and added at once
+     */
+    void filterColumns(const float* source, int width, const Kernel& kernel, int height, float* destination) {
+        size_t count = static_cast<size_t>(width) * 4;
+        for (int y = 0; y < height; y++) {
+            float* out = destination + y * count;
+            std::fill(out, out + count, 0.0f);
+            for (int k = 0; k < kernel.taps; k++) {
+                const float* row = source + kernel.indices[y * kernel.taps + k] * count;
+                float w = kernel.weights[y * kernel.taps + k];
+                size_t i = 0;
+#if defined(__AVX2__)
+                __m256 weights = _mm256_set1_ps(w);
+                for (; i + 8 <= count; i += 8) {
+                    _mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_loadu_ps(out + i), _mm256_mul_ps(_mm256_loadu_ps(row + i), weights)));
+                }
+#endif
+#if defined(__AVX2__) || defined(MIP_GENERATOR_SSE2)
+                __m128 weight4 = _mm_set1_ps(w);
+                for (; i + 4 <= count; i += 4) {
+                    _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), _mm_mul_ps(_mm_loadu_ps(row + i), weight4)));
+                }
+#endif
+                for (; i < count; i++) {
+                    out[i] += row[i] * w;
+                }
+            }
+        }
+    }
+
+    float srgbToLinear(float c) {
+        return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+    }
+
+    const std::array<float, 256>& decodeTable() {
+        static const std::array<float, 256> table = [] {
+            std::array<float, 256> values;
+            for (int i = 0; i < 256; i++) {
+                values[i] = srgbToLinear(i / 255.0f);
+            }
+            return values;
+        }();
+        return table;
+    }
+
+    /**
+     * @brief Linear values half way between two consecutive sRGB codes, the encoding rounds in sRGB space
+     */
+    const std::array<float, 255>& encodeThresholds() {
+        static const std::array<float, 255> table = [] {
+            std::array<float, 255> values;
+            for (int i = 0; i < 255; i++) {
+                values[i] = srgbToLinear((i + 0.5f) / 255.0f);
+            }
+            return values;
+        }();
+        return table;
+    }
+
+    unsigned char linearToSrgb(float value) {
+        const std::array<float, 255>& thresholds = encodeThresholds();
+        return static_cast<unsigned char>(std::upper_bound(thresholds.begin(), thresholds.end(), value) - thresholds.begin());
+    }
+
+    /**
+     * @brief Expand a level to RGBA floats, missing channels are 0 and missing alpha is 1
+     */
+    void expand(const TextureImage& image, const TextureLevel& level, bool srgb, std::vector<float>& rgba) {
+        size_t texels = static_cast<size_t>(level.width) * level.height;
+        rgba.assign(texels * 4, 0.0f);
+        const unsigned char* data = image.data() + level.offset;
+        const std::array<float, 256>& decode = decodeTable();
+
+        for (size_t i = 0; i < texels; i++) {
+            rgba[i * 4 + 3] = 1.0f;
+            for (int c = 0; c < image.channels; c++) {
+                if (image.type == GL_FLOAT) {
+                    std::memcpy(&rgba[i * 4 + c], data + (i * image.channels + c) * sizeof(float), sizeof(float));
+                } else if (srgb && c < 3) {
+                    rgba[i * 4 + c] = decode[data[i * image.channels + c]];
+                } else {
+                    rgba[i * 4 + c] = data[i * image.channels + c] / 255.0f;
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Pack RGBA floats back in the channels and type of the image
+     */
+    void pack(const std::vector<float>& rgba, size_t texels, const TextureImage& image, bool srgb, unsigned char* data) {
+        for (size_t i = 0; i < texels; i++) {
+            for (int c = 0; c < image.channels; c++) {
+                float value = rgba[i * 4 + c];
+                if (image.type == GL_FLOAT) {
+                    std::memcpy(data + (i * image.channels + c) * sizeof(float), &value, sizeof(float));
+                } else if (srgb && c < 3) {
+                    data[i * image.channels + c] = linearToSrgb(value);
+                } else {
+                    data[i * image.channels + c] = static_cast<unsigned char>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+                }
+            }
+        }
+    }
+}
+
+bool MipGenerator::generate(TextureImage& image, const Options& options) {
+    if (image.compressed || image.levels.empty() || image.channels < 1 || image.channels > 4
+        || (image.type != GL_UNSIGNED_BYTE && image.type != GL_FLOAT)) {
+        return false;
+    }
+
+    bool srgb = options.srgb && image.type == GL_UNSIGNED_BYTE && image.channels >= 3;
+    size_t texelSize = image.channels * (image.type == GL_FLOAT ? sizeof(float) : 1);
+
+    TextureLevel base = image.levels[0];
+    std::vector<float> current, rows, next;
+    expand(image, base, srgb, current);
+
+    // The levels are rebuilt in an owned buffer, the base level may come from a mapping
+    std::vector<unsigned char> pixels(image.data() + base.offset, image.data() + base.offset + base.size);
+    std::vector<TextureLevel> levels = { { 0, base.size, base.width, base.height } };
+
+    int width = base.width, height = base.height;
+    while (width > 1 || height > 1) {
+        int nextWidth = std::max(1, width / 2);
+        int nextHeight = std::max(1, height / 2);
+
+        rows.resize(static_cast<size_t>(nextWidth) * height * 4);
+        filterRows(current.data(), width, height, buildKernel(width, nextWidth, options), nextWidth, rows.data());
+        next.resize(static_cast<size_t>(nextWidth) * nextHeight * 4);
+        filterColumns(rows.data(), nextWidth, buildKernel(height, nextHeight, options), nextHeight, next.data());
+
+        size_t texels = static_cast<size_t>(nextWidth) * nextHeight;
+        levels.push_back({ pixels.size(), texels * texelSize, nextWidth, nextHeight });
+        pixels.resize(pixels.size() + texels * texelSize);
+        pack(next, texels, image, srgb, pixels.data() + levels.back().offset);
+
+        std::swap(current, next);
+        width = nextWidth;
+        height = nextHeight;
+    }
+
+    image.levels = std::move(levels);
+    image.pixels = std::move(pixels);
+    image.mapping.reset();
+    image.mappingOffset = 0;
+    image.mappingSize = 0;
+    return true;
+}
+
+std::string MipGenerator::describe(const Options& options) {
+    const char* filters[] = { "box", "kaiser", "lanczos" };
+    return std::string("mips=") + filters[static_cast<int>(options.filter)] + (options.srgb ? ",srgb" : "") + (options.wrap ? ",wrap" : ",clamp");
+}
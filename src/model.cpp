@@ -0,0 +1,178 @@
+#include "headers/model.hpp"
+#include "headers/mesh_processing.hpp"
+#include "headers/model_importer.hpp"
+#include "headers/texture.hpp"
+#include "headers/thread_pool.hpp"
+#include "headers/transform.hpp"
+#include "headers/vertex_array.hpp"
+#include "headers/logger.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <chrono>
+
+namespace uniforms {
+    constexpr Uniform<int> modelDiffuse{ "material.diffuse" };
+    constexpr Uniform<int> modelSpecular{ "material.specular" };
+    constexpr Uniform<glm::mat4> modelTransform{ "model" };
+    constexpr Uniform<glm::mat3> modelNormalMatrix{ "normalMatrix" };
+    constexpr Uniform<glm::vec4> modelTexCoordTransform{ "texCoordTransform" };
+}
+
+Model::Model(std::string path, glm::vec3 position, bool optimize) : m_path(std::move(path)), m_import(std::make_shared<Import>()) {
+    m_transform = glm::translate(glm::mat4(1.0f), position);
+
+    // The job keeps the import alive, the model can be deleted while it runs
+    ThreadPool::loaders().submit([import = m_import, path = m_path, optimize]() {
+        auto start = std::chrono::steady_clock::now();
+        // A stale or unreadable cooked file falls back to assimp
+        if (MeshFile::isCooked(path) && import->cooked.open(MeshFile::cookedPath(path))) {
+            import->fromCooked = true;
+            import->succeeded = true;
+            import->progress.store(1.0f, std::memory_order_relaxed);
+        } else {
+            import->succeeded = ModelImporter::import(path, import->mesh, &import->progress, optimize);
+        }
+        if (import->succeeded) {
+            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+            logger.log(std::string(import->fromCooked ? "Mapped cooked model " : "Imported model ") + path + " in " + std::to_string(elapsed.count()) + " ms");
+        }
+        import->done.store(true, std::memory_order_release);
+    });
+}
+
+Model::~Model() {
+    if (m_vertexBuffer != 0) {
+        VertexArrayCache::release(m_vertexBuffer);
+        glDeleteBuffers(1, &m_vertexBuffer);
+        glDeleteBuffers(1, &m_indexBuffer);
+    }
+}
+
+float Model::getProgress() const {
+    return m_import ? m_import->progress.load(std::memory_order_relaxed) : 1.0f;
+}
+
+bool Model::hasFailed() const {
+    return m_import && m_import->done.load(std::memory_order_acquire) && !m_import->succeeded;
+}
+
+MeshBounds Model::getBounds() const {
+    MeshBounds bounds;
+    if (!isReady()) {
+        return bounds;
+    }
+    // Corners of the box moved to world space
+    for (int corner = 0; corner < 8; corner++) {
+        glm::vec3 point((corner & 1) ? m_bounds.max.x : m_bounds.min.x, (corner & 2) ? m_bounds.max.y : m_bounds.min.y,
+                        (corner & 4) ? m_bounds.max.z : m_bounds.min.z);
+        bounds.extend(glm::vec3(m_transform * glm::vec4(point, 1.0f)));
+    }
+    return bounds;
+}
+
+VertexLayout Model::getVertexLayout() const {
+    if (isReady()) {
+        return m_layout;
+    }
+    if (m_import && m_import->done.load(std::memory_order_acquire) && m_import->fromCooked) {
+        return m_import->cooked.getVertexLayout();
+    }
+    return VertexLayout::FLOAT;
+}
+
+void Model::upload() {
+    const MeshData& mesh = m_import->mesh;
+    const MeshFile& cooked = m_import->cooked;
+    bool fromCooked = m_import->fromCooked;
+
+    const void* vertices = fromCooked ? cooked.getVertices() : mesh.vertices.data();
+    size_t vertexBytes = fromCooked ? cooked.getVertexBytes() : mesh.vertices.size() * sizeof(MeshVertex);
+
+    // Imported indices are narrowed here, cooked ones already are
+    std::vector<uint8_t> packed;
+    if (!fromCooked) {
+        m_indexType = MeshProcessing::indexType(mesh.vertices.size());
+        packed = MeshProcessing::packIndices(mesh.indices, m_indexType);
+    } else {
+        m_indexType = cooked.getIndexType();
+    }
+    const void* indices = fromCooked ? cooked.getIndices() : packed.data();
+    size_t indexBytes = fromCooked ? cooked.getIndexBytes() : packed.size();
+
+    if (!m_import->succeeded || indexBytes == 0) {
+        // Failed imports are only reported once
+        if (m_import->succeeded) {
+            logger.error("Model " + m_path + " has no triangles");
+        }
+        m_import->succeeded = false;
+        return;
+    }
+
+    glGenBuffers(1, &m_vertexBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+    // Cooked streams are read straight from the mapped file, the pages are only touched by this copy
+    glBufferData(GL_ARRAY_BUFFER, vertexBytes, vertices, GL_STATIC_DRAW);
+    glGenBuffers(1, &m_indexBuffer);
+    // The element binding belongs to the bound vertex array, the buffer is filled through the copy target instead
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_indexBuffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, indexBytes, indices, GL_STATIC_DRAW);
+
+    // Textures load on their own, the model is drawn with their placeholders meanwhile
+    for (const MeshMaterial& material : fromCooked ? cooked.getMaterials() : mesh.materials) {
+        Material textures;
+        if (!material.diffuse.empty()) {
+            textures.diffuse = Texture::getTextureFromFile(material.diffuse, aiTextureType_DIFFUSE, false);
+        }
+        if (!material.specular.empty()) {
+            textures.specular = Texture::getTextureFromFile(material.specular, aiTextureType_SPECULAR, false);
+        }
+        m_materials.push_back(std::move(textures));
+    }
+
+    m_layout = fromCooked ? cooked.getVertexLayout() : VertexLayout::FLOAT;
+    m_decode = fromCooked ? cooked.getDecode() : VertexQuantization::Decode();
+    m_submeshes = fromCooked ? cooked.getSubmeshes() : mesh.submeshes;
+    m_bounds = fromCooked ? cooked.getBounds() : mesh.bounds;
+    // The arrays and the mapping only lived for the upload
+    m_import.reset();
+}
+
+void Model::draw(const Shader& shader, float screenSize) {
+    if (!isReady()) {
+        if (!m_import || !m_import->done.load(std::memory_order_acquire) || !m_import->succeeded) {
+            return;
+        }
+        upload();
+        if (!isReady()) {
+            return;
+        }
+    }
+
+    GLuint vao = VertexArrayCache::get(VertexQuantization::format(m_layout), m_vertexBuffer, m_indexBuffer, shader);
+    if (vao == 0) {
+        return;
+    }
+
+    shader.set(uniforms::modelDiffuse, 0);
+    shader.set(uniforms::modelSpecular, 1);
+    // Quantized positions are decoded by the model matrix, the normals are decoded apart and keep the matrix of the model alone
+    shader.set(uniforms::modelTransform, m_transform * m_decode.positionTransform());
+    shader.set(uniforms::modelNormalMatrix, computeNormalMatrix(m_transform));
+    if (m_layout != VertexLayout::FLOAT) {
+        shader.set(uniforms::modelTexCoordTransform, m_decode.texCoordTransform());
+    }
+    glBindVertexArray(vao);
+
+    for (const Submesh& submesh : m_submeshes) {
+        if (submesh.material < m_materials.size()) {
+            const Material& material = m_materials[submesh.material];
+            material.diffuse.request(screenSize);
+            material.specular.request(screenSize);
+            Texture::bind(0, GL_TEXTURE_2D, material.diffuse.getID());
+            Texture::bind(1, GL_TEXTURE_2D, material.specular.getID());
+        }
+        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(submesh.indexCount), m_indexType,
+                       reinterpret_cast<const void*>(static_cast<uintptr_t>(submesh.firstIndex) * MeshProcessing::indexSize(m_indexType)));
+    }
+}
@@ -0,0 +1,122 @@
+#include "headers/model_importer.hpp"
+#include "headers/mesh_processing.hpp"
+#include "headers/logger.hpp"
+
+#include <assimp/Importer.hpp>
+#include <assimp/ProgressHandler.hpp>
+#include <assimp/postprocess.h>
+#include <assimp/scene.h>
+
+#include <filesystem>
+
+namespace {
+    /**
+     * @brief Forwards the progress of assimp, reading the file and the post processing steps
+     * make up most of the import so they're reported up to 90%
+     */
+    class ImportProgress : public Assimp::ProgressHandler {
+    public:
+        explicit ImportProgress(std::atomic<float>* progress) : m_progress(progress) {}
+
+        bool Update(float percentage) override {
+            if (m_progress != nullptr && percentage >= 0.0f) {
+                m_progress->store(std::min(percentage, 1.0f) * 0.9f, std::memory_order_relaxed);
+            }
+            return true;
+        }
+
+    private:
+        std::atomic<float>* m_progress;
+    };
+
+    std::string texturePath(const aiMaterial* material, aiTextureType type, const std::filesystem::path& directory) {
+        aiString path;
+        if (material->GetTextureCount(type) == 0 || material->GetTexture(type, 0, &path) != AI_SUCCESS) {
+            return {};
+        }
+        return (directory / path.C_Str()).lexically_normal().generic_string();
+    }
+}
+
+bool ModelImporter::import(const std::string& filename, MeshData& mesh, std::atomic<float>* progress, bool optimize) {
+    // Importers aren't thread safe, each loader thread keeps its own instead of creating one per model
+    thread_local Assimp::Importer importer;
+
+    ImportProgress handler(progress);
+    importer.SetProgressHandler(&handler);
+    // The hierarchy is baked in the vertices, the engine draws a model as a single mesh.
+    // Duplicates are welded once the meshes are flattened instead of by assimp, across submeshes too
+    const aiScene* scene = importer.ReadFile(filename, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_PreTransformVertices
+                                                       | aiProcess_SortByPType | aiProcess_FlipUVs);
+    // The importer would delete the handler, it lives on this stack
+    importer.SetProgressHandler(nullptr);
+
+    if (scene == nullptr || (scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE) != 0) {
+        logger.error("Failed to import model " + filename + ": " + importer.GetErrorString());
+        return false;
+    }
+
+    std::filesystem::path directory = std::filesystem::path(filename).parent_path();
+    mesh = MeshData{};
+    for (unsigned int i = 0; i < scene->mNumMaterials; i++) {
+        const aiMaterial* material = scene->mMaterials[i];
+        mesh.materials.push_back({ texturePath(material, aiTextureType_DIFFUSE, directory), texturePath(material, aiTextureType_SPECULAR, directory) });
+    }
+
+    size_t vertexCount = 0, indexCount = 0;
+    for (unsigned int i = 0; i < scene->mNumMeshes; i++) {
+        vertexCount += scene->mMeshes[i]->mNumVertices;
+        indexCount += static_cast<size_t>(scene->mMeshes[i]->mNumFaces) * 3;
+    }
+    mesh.vertices.reserve(vertexCount);
+    mesh.indices.reserve(indexCount);
+
+    for (unsigned int i = 0; i < scene->mNumMeshes; i++) {
+        const aiMesh* source = scene->mMeshes[i];
+        // Points and lines are split in meshes of their own by aiProcess_SortByPType
+        if ((source->mPrimitiveTypes & aiPrimitiveType_TRIANGLE) == 0) {
+            continue;
+        }
+
+        Submesh submesh;
+        submesh.firstIndex = static_cast<uint32_t>(mesh.indices.size());
+        submesh.material = source->mMaterialIndex;
+
+        uint32_t baseVertex = static_cast<uint32_t>(mesh.vertices.size());
+        for (unsigned int v = 0; v < source->mNumVertices; v++) {
+            MeshVertex vertex;
+            vertex.position = glm::vec3(source->mVertices[v].x, source->mVertices[v].y, source->mVertices[v].z);
+            vertex.normal = source->HasNormals() ? glm::vec3(source->mNormals[v].x, source->mNormals[v].y, source->mNormals[v].z) : glm::vec3(0.0f);
+            vertex.texCoords = source->HasTextureCoords(0) ? glm::vec2(source->mTextureCoords[0][v].x, source->mTextureCoords[0][v].y) : glm::vec2(0.0f);
+            mesh.vertices.push_back(vertex);
+            submesh.bounds.extend(vertex.position);
+        }
+
+        for (unsigned int f = 0; f < source->mNumFaces; f++) {
+            const aiFace& face = source->mFaces[f];
+            if (face.mNumIndices != 3) {
+                continue;
+            }
+            for (unsigned int k = 0; k < 3; k++) {
+                mesh.indices.push_back(baseVertex + face.mIndices[k]);
+            }
+        }
+
+        submesh.indexCount = static_cast<uint32_t>(mesh.indices.size()) - submesh.firstIndex;
+        mesh.bounds.extend(submesh.bounds);
+        mesh.submeshes.push_back(submesh);
+    }
+
+    // Frees the scene now instead of keeping it until the next import on this thread
+    importer.FreeScene();
+    MeshProcessing::weld(mesh);
+    if (optimize) {
+        MeshProcessing::OptimizeStats stats = MeshProcessing::optimize(mesh);
+        logger.log("Optimized model " + filename + ": ACMR " + std::to_string(stats.before.acmr) + " -> " + std::to_string(stats.after.acmr) + ", ATVR "
+                   + std::to_string(stats.before.atvr) + " -> " + std::to_string(stats.after.atvr));
+    }
+    if (progress != nullptr) {
+        progress->store(1.0f, std::memory_order_relaxed);
+    }
+    return true;
+}
@@ -0,0 +1,123 @@
+#include "headers/program_cache.hpp"
+#include "headers/hash.hpp"
+#include "headers/logger.hpp"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+namespace {
+    // "AEPB", Another-Engine Program Binary
+    constexpr uint32_t MAGIC = 0x42504541;
+    constexpr uint32_t VERSION = 1;
+
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t format;
+        uint32_t length;
+    };
+
+    std::string glString(GLenum name) {
+        const GLubyte* str = glGetString(name);
+        return str ? std::string(reinterpret_cast<const char*>(str)) : std::string();
+    }
+}
+
+uint64_t ProgramCache::key(const std::string& vertexCode, const std::string& fragmentCode) {
+    // The separators prevent two different splits of the same text from sharing a key
+    uint64_t hash = fnv1a(vertexCode);
+    hash = fnv1a(std::string_view("\0", 1), hash);
+    hash = fnv1a(fragmentCode, hash);
+    hash = fnv1a(std::string_view("\0", 1), hash);
+    hash = fnv1a(glString(GL_RENDERER), hash);
+    hash = fnv1a(std::string_view("\0", 1), hash);
+    return fnv1a(glString(GL_VERSION), hash);
+}
+
+bool ProgramCache::isSupported() {
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    return formats > 0;
+}
+
+std::string ProgramCache::path(uint64_t key) {
+    char name[17];
+    std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key));
+    return s_directory + name + ".bin";
+}
+
+bool ProgramCache::load(GLuint program, uint64_t key) {
+    std::ifstream file(path(key), std::ios::binary);
+    if (!file.is_open()) {
+        s_misses++;
+        return false;
+    }
+
+    Header header{};
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    std::vector<char> binary;
+    // The length comes from the file, a corrupt one can't claim more bytes than the file has left
+    std::error_code sizeError;
+    uintmax_t remaining = file ? std::filesystem::file_size(path(key), sizeError) - sizeof(header) : 0;
+    if (file && header.magic == MAGIC && header.version == VERSION && !sizeError && header.length <= remaining) {
+        binary.resize(header.length);
+        file.read(binary.data(), header.length);
+    }
+    bool complete = file && !binary.empty();
+    file.close();
+
+    if (!complete) {
+        // Truncated or outdated file, it will be replaced after the next link
+        logger.warn("PROGRAM_CACHE::STALE_BINARY " + path(key));
+        std::error_code error;
+        std::filesystem::remove(path(key), error);
+        s_misses++;
+        return false;
+    }
+
+    glProgramBinary(program, header.format, binary.data(), static_cast<GLsizei>(binary.size()));
+    return true;
+}
+
+bool ProgramCache::validate(GLuint program, uint64_t key) {
+    GLint success = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+
+    if (!success) {
+        // The driver changed in a way the key doesn't capture, it will be replaced after the next link
+        logger.warn("PROGRAM_CACHE::REJECTED_BINARY " + path(key));
+        std::error_code error;
+        std::filesystem::remove(path(key), error);
+        s_misses++;
+        return false;
+    }
+
+    s_hits++;
+    return true;
+}
+
+void ProgramCache::store(GLuint program, uint64_t key) {
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &length, &format, binary.data());
+
+    std::error_code error;
+    std::filesystem::create_directories(s_directory, error);
+    std::ofstream file(path(key), std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        logger.warn("PROGRAM_CACHE::CANNOT_WRITE " + path(key));
+        return;
+    }
+
+    Header header{ MAGIC, VERSION, format, static_cast<uint32_t>(length) };
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(binary.data(), length);
+}
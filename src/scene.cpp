@@ -1,6 +1,12 @@
 #include "headers/scene.hpp"
 #include "headers/texture.hpp"
+#include "headers/texture_cache.hpp"
 #include "headers/logger.hpp"
+#include "headers/frame_data.hpp"
+#include "headers/mesh_processing.hpp"
+#include "headers/shader_watcher.hpp"
+#include "headers/transform.hpp"
+#include "headers/vertex_array.hpp"
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -18,6 +24,25 @@ float lastX, lastY;
 Camera camera;
 bool camera_control = false;
 
+// Uniform handles used by the render loop, hashed at compile time
+namespace uniforms {
+	constexpr Uniform<int> materialAtlas{ "material.atlas" };
+	constexpr Uniform<glm::vec4> materialDiffuseRect{ "material.diffuseRect" };
+	constexpr Uniform<float> materialDiffuseLayer{ "material.diffuseLayer" };
+	constexpr Uniform<glm::vec4> materialSpecularRect{ "material.specularRect" };
+	constexpr Uniform<float> materialSpecularLayer{ "material.specularLayer" };
+	constexpr Uniform<float> materialShininess{ "material.shininess" };
+	constexpr Uniform<glm::vec3> lightPosition{ "light.position" };
+	constexpr Uniform<glm::vec3> lightAmbient{ "light.ambient" };
+	constexpr Uniform<glm::vec3> lightDiffuse{ "light.diffuse" };
+	constexpr Uniform<glm::vec3> lightSpecular{ "light.specular" };
+	constexpr Uniform<glm::mat4> model{ "model" };
+	constexpr Uniform<glm::mat3> normalMatrix{ "normalMatrix" };
+}
+
+// Bytes of decoded textures uploaded per frame at most, keeps frame times stable while assets stream in
+constexpr size_t TEXTURE_UPLOAD_BUDGET = 8 * 1024 * 1024;
+
 uint16_t Scene::width = 800;
 uint16_t Scene::height = 600;
 
@@ -29,6 +54,10 @@ Scene::Scene(uint16_t width, uint16_t height) {
 }
 
 Scene::~Scene() {
+	for (Model* model : models) {
+		delete model;
+	}
+	delete atlas;
 	glfwDestroyWindow(window);
 	glfwTerminate();
 }
@@ -106,6 +135,7 @@ void Scene::renderLoop() {
 	double current = 0;
 	float lastFrame = 0.0f;
 	int frame = 0;
+	double lastStats = 0;
 
 	glfwSetCursorPosCallback(this->window, mouse_callback);
     glfwSetInputMode(this->window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
@@ -159,53 +189,76 @@ void Scene::renderLoop() {
         -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  1.0f
     };
 
-    unsigned int VBO, cubeVAO;
-    glGenVertexArrays(1, &cubeVAO);
+    // The triangle list has the layout of MeshVertex, welded down to the 24 distinct corners of the faces
+    static_assert(sizeof(MeshVertex) == 8 * sizeof(float), "The cube vertices are MeshVertex");
+    MeshData cube = MeshProcessing::fromTriangles(reinterpret_cast<const MeshVertex*>(vertices), std::size(vertices) / 8);
+    GLenum cubeIndexType = MeshProcessing::indexType(cube.vertices.size());
+    std::vector<uint8_t> cubeIndices = MeshProcessing::packIndices(cube.indices, cubeIndexType);
+    GLsizei cubeIndexCount = static_cast<GLsizei>(cube.indices.size());
+
+    unsigned int VBO, EBO;
     glGenBuffers(1, &VBO);
+    glGenBuffers(1, &EBO);
 
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-    glBindVertexArray(cubeVAO);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
+    glBufferData(GL_ARRAY_BUFFER, cube.vertices.size() * sizeof(MeshVertex), cube.vertices.data(), GL_STATIC_DRAW);
+    // The element binding belongs to the bound vertex array, the buffer is filled through the copy target instead
+    glBindBuffer(GL_COPY_WRITE_BUFFER, EBO);
+    glBufferData(GL_COPY_WRITE_BUFFER, cubeIndices.size(), cubeIndices.data(), GL_STATIC_DRAW);
 
-    // second, configure the light's VAO (VBO stays the same; the vertices are the same for the light object which is also a 3D cube)
-    unsigned int lightCubeVAO;
-    glGenVertexArrays(1, &lightCubeVAO);
-    glBindVertexArray(lightCubeVAO);
+    // The vertex arrays are built from this format and the inputs of each program, see VertexArrayCache
+    VertexFormat cubeFormat = MeshData::vertexFormat();
 
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    // note that we update the lamp's position attribute's stride to reflect the updated buffer data
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
+    glm::vec3 lightPos(1.2f, 1.0f, 2.0f);
 
-    // load textures (we now use a utility function to keep the code more organized)
-    // -----------------------------------------------------------------------------
-    Texture diffuseMap = Texture::getTextureFromFile(std::string("textures/container2.png"), aiTextureType_UNKNOWN, false);
-    Texture specularMap = Texture::getTextureFromFile(std::string("textures/container2_specular.png"), aiTextureType_UNKNOWN, false);
+    FrameDataBuffer frameDataBuffer;
 
-    glm::vec3 lightPos(1.2f, 1.0f, 2.0f);
+    std::vector<Shader*> watchedShaders;
+    for (auto& [name, shader] : this->shaders) {
+        watchedShaders.push_back(shader);
+    }
+    ShaderWatcher shaderWatcher("shaders", watchedShaders);
     
     Shader* lightShader = this->shaders.find("light")->second;
     Shader* cubeShader = this->shaders.find("cube")->second;
+    Shader* modelShader = this->shaders.find("model")->second;
+    Shader* compactModelShader = this->shaders.find("model-compact")->second;
     Material* goldMaterial = this->materials.find("emerald")->second;
-
-     // shader configuration
-    // --------------------
-    lightShader->use();
-    lightShader->setInt("material.diffuse", 0);
-    lightShader->setInt("material.specular", 1);
+    Material* containerMaterial = this->materials.find("container")->second;
 
 	while (!glfwWindowShouldClose(window)) {
 		current = glfwGetTime();
 		deltaTime = current - lastFrame;
 		lastFrame = current;
 
+		// Report the counters of the last frame once per second
+		frame++;
+		if (current - lastStats >= 1.0) {
+			const ShaderStats& stats = Shader::getFrameStats();
+			TextureCache::Stats textures = TextureCache::getStats();
+			logger.log(std::to_string(frame) + " fps, uniform lookups/frame: " + std::to_string(stats.driverLookups)
+					   + ", unknown uniforms/frame: " + std::to_string(stats.unknownUniforms)
+					   + ", uploads issued/skipped: " + std::to_string(stats.issuedUploads) + "/" + std::to_string(stats.skippedUploads)
+					   + ", binds issued/skipped: " + std::to_string(stats.issuedBinds) + "/" + std::to_string(stats.skippedBinds)
+					   + ", texture binds issued/skipped: " + std::to_string(Texture::getFrameStats().issuedBinds) + "/" + std::to_string(Texture::getFrameStats().skippedBinds)
+					   + ", pending programs: " + std::to_string(stats.pendingPrograms)
+					   + ", pending texture uploads: " + std::to_string(Texture::getPendingUploads())
+					   + ", missing mip levels: " + std::to_string(Texture::getMissingLevels())
+					   + ", textures: " + std::to_string(textures.textures)
+					   + " (" + std::to_string(textures.residentBytes >> 20) + "/" + std::to_string(textures.budgetBytes >> 20) + " MB"
+					   + ", hits/misses: " + std::to_string(textures.hits) + "/" + std::to_string(textures.misses)
+					   + ", evictions: " + std::to_string(textures.evictions) + ")");
+			frame = 0;
+			lastStats = current;
+		}
+		Shader::resetFrameStats();
+		Texture::resetFrameStats();
+
+        // Hand the shaders edited on disk to the driver, the previous programs are used until they're ready
+        shaderWatcher.update();
+        // Textures decoded by the loader threads replace their placeholder
+        Texture::processUploads(TEXTURE_UPLOAD_BUDGET);
+
         camera.processInput(window, deltaTime);
 	    camera.update();
 
@@ -213,52 +266,91 @@ void Scene::renderLoop() {
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         
-        lightShader->use();
-        lightShader->setVec3("light.position", lightPos);
-        lightShader->setVec3("viewPos", camera.getPos());
-
-        // light properties
-        lightShader->setVec3("light.ambient", glm::vec3(0.2f, 0.2f, 0.2f));
-        lightShader->setVec3("light.diffuse", glm::vec3(0.5f, 0.5f, 0.5f));
-        lightShader->setVec3("light.specular", glm::vec3(1.0f, 1.0f, 1.0f));
-
-        // material properties
-        lightShader->setFloat("material.shininess", 8.0f);
-
-        // view/projection transformations
-        glm::mat4 projection = glm::perspective(glm::radians(camera.getZoom()), (float)width / (float)height, 0.1f, 100.0f);
-        glm::mat4 view = camera.getLookAtMatrix();
-        lightShader->setMatrix4("projection", projection);
-        lightShader->setMatrix4("view", view);
-
-        // world transformation
-        glm::mat4 model = glm::mat4(1.0f);
-        lightShader->setMatrix4("model", model);
-
-        // bind diffuse map
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, diffuseMap.getID());
-        // bind specular map
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, specularMap.getID());
-
-        // render the cube
-        glBindVertexArray(cubeVAO);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
+        // view/projection transformations, shared by every program through the FrameData block
+        FrameData frameData;
+        frameData.projection = glm::perspective(glm::radians(camera.getZoom()), (float)width / (float)height, 0.1f, 100.0f);
+        frameData.view = camera.getLookAtMatrix();
+        frameData.viewProjection = frameData.projection * frameData.view;
+        frameData.cameraPos = glm::vec4(camera.getPos(), 1.0f);
+        frameData.viewport = glm::vec4(width, height, 1.0f / width, 1.0f / height);
+        frameData.time = (float)current;
+        frameData.deltaTime = deltaTime;
+        frameDataBuffer.update(frameData);
+
+        // Programs still compiling are skipped instead of stalling the frame
+        if (lightShader->isReady()) {
+            lightShader->use();
+            lightShader->set(uniforms::materialAtlas, 0);
+            lightShader->set(uniforms::lightPosition, lightPos);
+
+            // light properties
+            lightShader->set(uniforms::lightAmbient, glm::vec3(0.2f, 0.2f, 0.2f));
+            lightShader->set(uniforms::lightDiffuse, glm::vec3(0.5f, 0.5f, 0.5f));
+            lightShader->set(uniforms::lightSpecular, glm::vec3(1.0f, 1.0f, 1.0f));
+
+            // material properties, its maps are regions of the atlas
+            const AtlasRegion& diffuseMap = containerMaterial->getDiffuseMap();
+            const AtlasRegion& specularMap = containerMaterial->getSpecularMap();
+            lightShader->set(uniforms::materialDiffuseRect, diffuseMap.rect);
+            lightShader->set(uniforms::materialDiffuseLayer, static_cast<float>(diffuseMap.layer));
+            lightShader->set(uniforms::materialSpecularRect, specularMap.rect);
+            lightShader->set(uniforms::materialSpecularLayer, static_cast<float>(specularMap.layer));
+            lightShader->set(uniforms::materialShininess, containerMaterial->getShininess());
+
+            // world transformation
+            glm::mat4 model = glm::mat4(1.0f);
+            lightShader->set(uniforms::model, model);
+            lightShader->set(uniforms::normalMatrix, computeNormalMatrix(model));
+
+            // every material of the atlas samples the same array, only the first draw binds it
+            atlas->bind(0);
+
+            // render the cube
+            GLuint cubeVAO = VertexArrayCache::get(cubeFormat, VBO, EBO, *lightShader);
+            if (cubeVAO != 0) {
+                glBindVertexArray(cubeVAO);
+                glDrawElements(GL_TRIANGLES, cubeIndexCount, cubeIndexType, nullptr);
+            }
+        }
 
+        // imported models sample their own textures, they're skipped until their buffers are uploaded.
+        // models cooked in a compact layout decode their vertices in their own variant
+        for (auto [shader, compact] : { std::pair{ modelShader, false }, std::pair{ compactModelShader, true } }) {
+            if (!shader->isReady()) {
+                continue;
+            }
+            shader->use();
+            shader->set(uniforms::lightPosition, lightPos);
+            shader->set(uniforms::lightAmbient, glm::vec3(0.2f, 0.2f, 0.2f));
+            shader->set(uniforms::lightDiffuse, glm::vec3(0.5f, 0.5f, 0.5f));
+            shader->set(uniforms::lightSpecular, glm::vec3(1.0f, 1.0f, 1.0f));
+            shader->set(uniforms::materialShininess, 32.0f);
+
+            for (Model* model : models) {
+                if ((model->getVertexLayout() != VertexLayout::FLOAT) != compact) {
+                    continue;
+                }
+                MeshBounds bounds = model->getBounds();
+                float screenSize = model->isReady() ? camera.projectedSize(bounds.center(), bounds.radius(), height) : 0.0f;
+                model->draw(*shader, screenSize);
+            }
+        }
 
         // also draw the lamp object
-        cubeShader->use();
-        cubeShader->setMatrix4("projection", projection);
-        cubeShader->setMatrix4("view", view);
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, lightPos);
-        model = glm::scale(model, glm::vec3(0.2f)); // a smaller cube
-        cubeShader->setMatrix4("model", model);
-
-        glBindVertexArray(lightCubeVAO);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-
+        if (cubeShader->isReady()) {
+            cubeShader->use();
+            glm::mat4 model = glm::mat4(1.0f);
+            model = glm::translate(model, lightPos);
+            model = glm::scale(model, glm::vec3(0.2f)); // a smaller cube
+            cubeShader->set(uniforms::model, model);
+
+            // the lamp program only reads positions, so it gets its own vertex array over the same buffer
+            GLuint lightCubeVAO = VertexArrayCache::get(cubeFormat, VBO, EBO, *cubeShader);
+            if (lightCubeVAO != 0) {
+                glBindVertexArray(lightCubeVAO);
+                glDrawElements(GL_TRIANGLES, cubeIndexCount, cubeIndexType, nullptr);
+            }
+        }
 
 		glfwSwapBuffers(window);
         glfwPollEvents();
@@ -269,10 +361,19 @@ void Scene::renderLoop() {
 void Scene::setupScene() {
 	// this->addLight(new PointLight(glm::vec3(17.0f, 17.0f, -20.0f), glm::vec3(1.0f, 1.0f, 1.0f), 2.0f, 0.5f, 0.4f,1.0f,0.014, 0.0007));
 	// this->addLight(new DirectionalLight(glm::vec3(-0.2f, -1.0f, -0.3f), glm::vec3(0.5f, 0.5f, 0.5f), 0.5, 0.5));
-	// this->addModel(new Model("models/backpack/backpack.obj", glm::vec3(0.0f, -2.0f, 0.0f)));
+	this->addModel(new Model("models/backpack/backpack.obj", glm::vec3(0.0f, -2.0f, 0.0f)));
 
-	this->addShader("light", new Shader{ "shaders/light.vs", "shaders/light.fs" });
-    this->addShader("cube", new Shader{ "shaders/cube.vs", "shaders/cube.fs" });
+	this->addShader("light", Shader::getVariant("shaders/light.vs", "shaders/light.fs", { { "SPECULAR_MAP", "" }, { "TEXTURE_ATLAS", "" } }));
+    this->addShader("cube", Shader::getVariant("shaders/cube.vs", "shaders/cube.fs"));
+    this->addShader("model", Shader::getVariant("shaders/light.vs", "shaders/light.fs", { { "SPECULAR_MAP", "" } }));
+    this->addShader("model-compact", Shader::getVariant("shaders/light.vs", "shaders/light.fs", { { "SPECULAR_MAP", "" }, { "COMPACT_VERTEX", "" } }));
+
+	// Compile every program at once, the render loop skips the ones which aren't ready yet
+	std::vector<Shader*> pending;
+	for (auto& [name, shader] : this->shaders) {
+		pending.push_back(shader);
+	}
+	Shader::submitAll(pending);
 
     this->addMaterial("gold", Material::create()->withAmbient(glm::vec3(0.24725, 0.1995, 0.0745))
                                                ->withDiffuse(glm::vec3(0.75164, 0.60648, 0.22648))
@@ -284,12 +385,27 @@ void Scene::setupScene() {
                                                ->withDiffuse(glm::vec3(0.07568,0.61424,0.07568))
                                                ->withSpecular(glm::vec3(0.633,0.727811,0.633))
                                                ->withShininess(0.6));
+
+    // The maps of every material are packed in one texture array
+    atlas = new TextureAtlas();
+    // Filtered like the maps of Texture, the diffuse map holds colors and the specular one data
+    uint32_t containerDiffuse = atlas->add("textures/container2.png", false, true);
+    uint32_t containerSpecular = atlas->add("textures/container2_specular.png", false, false);
+    atlas->build();
+
+    this->addMaterial("container", Material::create()->withDiffuseMap(atlas->getRegion(containerDiffuse))
+                                                 ->withSpecularMap(atlas->getRegion(containerSpecular))
+                                                 ->withShininess(8.0f / 128.0f));
 }
 
 void Scene::addShader(std::string name, Shader* shader) {
 	this->shaders.insert({ name, shader });
 }
 
+void Scene::addModel(Model* model) {
+	this->models.push_back(model);
+}
+
 void Scene::addMaterial(std::string name, Material* material) {
 	this->materials.insert({ name, material });
 }
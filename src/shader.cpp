@@ -1,151 +1,424 @@
 #include "headers/shader.hpp"
 #include "headers/logger.hpp"
+#include "headers/frame_data.hpp"
+#include "headers/program_cache.hpp"
 
-Shader::Shader(const char* vertexPath, const char* fragmentPath) {
+#include <algorithm>
 
-    this->vertexPath = vertexPath;
-    this->fragmentPath = fragmentPath;
-
-    std::string vertexCode, fragmentCode;
-    std::ifstream vShaderFile, fShaderFile;
-
-    // Ensure ifstream objects can throw exceptions:
-    vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-    fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+// Defined by GL_KHR_parallel_shader_compile, which glad hasn't been generated with
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
 
-    try {
-        vShaderFile.open(vertexPath);
-        fShaderFile.open(fragmentPath);
-        std::stringstream vShaderStream, fShaderStream;
+Shader::Shader(const char* vertexPath, const char* fragmentPath, const ShaderDefines& defines) {
 
-        vShaderStream << vShaderFile.rdbuf();
-        fShaderStream << fShaderFile.rdbuf();
+    this->vertexPath = vertexPath;
+    this->fragmentPath = fragmentPath;
+    this->m_defines = defines;
+}
 
-        vShaderFile.close();
-        fShaderFile.close();
+Shader* Shader::getVariant(const char* vertexPath, const char* fragmentPath, const ShaderDefines& defines) {
+    uint64_t key = ShaderPreprocessor::permutationKey(vertexPath, fragmentPath, defines);
 
-        vertexCode = vShaderStream.str();
-        fragmentCode = fShaderStream.str();
-    } catch (std::ifstream::failure& e) {
-        logger.error("SHADER::FILE_NOT_SUCCESFULLY_READ " + std::string(e.what()));
+    auto it = s_variants.find(key);
+    if (it == s_variants.end()) {
+        it = s_variants.emplace(key, new Shader{ vertexPath, fragmentPath, defines }).first;
     }
+    return it->second;
+}
 
-    const char* vShaderCode = vertexCode.c_str();
-    const char* fShaderCode = fragmentCode.c_str();
-
-    // Compile shaders
-    unsigned int vertex, fragment;
+void Shader::submitAll(const std::vector<Shader*>& shaders) {
+    s_batchStart = std::chrono::steady_clock::now();
+    s_batchRunning = true;
 
-    vertex = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex, 1, &vShaderCode, NULL);
-    glCompileShader(vertex);
-    checkCompileErrors(vertex, "VERTEX");
+    // Every program is handed to the driver before the first status query
+    for (Shader* shader : shaders) {
+        shader->submit();
+    }
+}
 
-    fragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment, 1, &fShaderCode, NULL);
-    glCompileShader(fragment);
-    checkCompileErrors(fragment, "FRAGMENT");
+void Shader::submit() {
+    std::string vertexCode, fragmentCode;
+    if (!readSources(vertexCode, fragmentCode)) {
+        m_status = FAILED;
+        return;
+    }
+    submit(vertexCode, fragmentCode, true);
+}
 
-    // shader Program
-    ID = glCreateProgram();
-    glAttachShader(ID, vertex);
-    glAttachShader(ID, fragment);
-    glLinkProgram(ID);
-    checkCompileErrors(ID, "PROGRAM");
+bool Shader::readSources(std::string& vertexCode, std::string& fragmentCode) {
+    std::vector<std::string> vertexDependencies, fragmentDependencies;
+    if (!ShaderPreprocessor::process(vertexPath, m_defines, vertexCode, vertexDependencies)
+        || !ShaderPreprocessor::process(fragmentPath, m_defines, fragmentCode, fragmentDependencies)) {
+        return false;
+    }
 
-    // delete the shaders as they're linked into our program now and no longer necessary
-    glDeleteShader(vertex);
-    glDeleteShader(fragment);
+    m_dependencies = vertexDependencies;
+    m_dependencies.insert(m_dependencies.end(), fragmentDependencies.begin(), fragmentDependencies.end());
+    return true;
 }
 
 void Shader::use() {
+	if (s_boundProgram == ID) {
+		s_frameStats.skippedBinds++;
+		return;
+	}
 	glUseProgram(ID);
+	s_boundProgram = ID;
+	s_frameStats.issuedBinds++;
+}
+
+ShaderStats Shader::s_frameStats;
+unsigned int Shader::s_boundProgram = 0;
+unsigned int Shader::s_pending = 0;
+std::chrono::steady_clock::time_point Shader::s_batchStart;
+bool Shader::s_batchRunning = false;
+std::unordered_map<uint64_t, Shader*> Shader::s_variants;
+
+int Shader::findUniform(uint64_t hash) const {
+    int index = m_uniforms.find(hash);
+    if (index == -1) {
+        s_frameStats.unknownUniforms++;
+    }
+    return index;
 }
 
 void Shader::setBool(const std::string& name, const bool value) const {
-	glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+	set(Uniform<bool>(name), value);
 }
 
 void Shader::setInt(const std::string& name, const int value) const {
-	glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+	set(Uniform<int>(name), value);
 }
 
 void Shader::setFloat(const std::string& name, const float value) const {
-	glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+	set(Uniform<float>(name), value);
 }
 
 void Shader::setMatrix4(const std::string& name, const glm::mat4& value) const {
-    glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, false, glm::value_ptr(value));
+    set(Uniform<glm::mat4>(name), value);
 }
 
 void Shader::setMatrix3(const std::string& name, const glm::mat3& value) const {
-    glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, false, glm::value_ptr(value));
+    set(Uniform<glm::mat3>(name), value);
 }
 
 void Shader::setVec3(const std::string& name, const glm::vec3& value) const {
-    glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+    set(Uniform<glm::vec3>(name), value);
 }
 
 void Shader::setVec2(const std::string& name, const glm::vec2& value) const {
-    glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+    set(Uniform<glm::vec2>(name), value);
 }
 
-void Shader::reload() {
-    glDeleteProgram(ID);
+void Shader::upload(GLint location, bool value) {
+    glUniform1i(location, (int)value);
+}
+
+void Shader::upload(GLint location, int value) {
+    glUniform1i(location, value);
+}
+
+void Shader::upload(GLint location, float value) {
+    glUniform1f(location, value);
+}
+
+void Shader::upload(GLint location, const glm::vec2& value) {
+    glUniform2fv(location, 1, &value[0]);
+}
+
+void Shader::upload(GLint location, const glm::vec3& value) {
+    glUniform3fv(location, 1, &value[0]);
+}
+
+void Shader::upload(GLint location, const glm::vec4& value) {
+    glUniform4fv(location, 1, &value[0]);
+}
 
+void Shader::upload(GLint location, const glm::mat3& value) {
+    glUniformMatrix3fv(location, 1, false, glm::value_ptr(value));
+}
+
+void Shader::upload(GLint location, const glm::mat4& value) {
+    glUniformMatrix4fv(location, 1, false, glm::value_ptr(value));
+}
+
+void Shader::reload() {
     std::string vertexCode, fragmentCode;
-    std::ifstream vShaderFile, fShaderFile;
+    if (!readSources(vertexCode, fragmentCode)) {
+        logger.error("SHADER::RELOAD_FAILED keeping the previous program of " + std::string(vertexPath));
+        return;
+    }
+    reload(vertexCode, fragmentCode, m_dependencies);
+}
 
-    // Ensure ifstream objects can throw exceptions:
-    vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-    fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+void Shader::reload(const std::string& vertexCode, const std::string& fragmentCode, const std::vector<std::string>& dependencies) {
+    m_dependencies = dependencies;
+    cancelBuild();
 
-    try {
-        vShaderFile.open(vertexPath);
-        fShaderFile.open(fragmentPath);
-        std::stringstream vShaderStream, fShaderStream;
+    // Edited sources are compiled from scratch, the binary cache would mean file I/O on the frame thread
+    submit(vertexCode, fragmentCode, false);
+}
 
-        vShaderStream << vShaderFile.rdbuf();
-        fShaderStream << fShaderFile.rdbuf();
+void Shader::cancelBuild() {
+    if (m_building == 0) {
+        return;
+    }
 
-        vShaderFile.close();
-        fShaderFile.close();
+    if (!m_fromBinary) {
+        glDeleteShader(m_vertex);
+        glDeleteShader(m_fragment);
+    }
+    glDeleteProgram(m_building);
+    m_building = 0;
+    s_pending--;
+}
 
-        vertexCode = vShaderStream.str();
-        fragmentCode = fShaderStream.str();
-    } catch (std::ifstream::failure& e) {
-        // std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ: " << e.what() << std::endl;
-        logger.error("SHADER::FILE_NOT_SUCCESFULLY_READ: " + std::string(e.what()));
+void Shader::submit(const std::string& vertexCode, const std::string& fragmentCode, bool useCache) {
+    m_building = glCreateProgram();
+    if (m_status != READY) {
+        m_status = PENDING;
+    }
+    s_pending++;
+
+    // A binary from a previous run skips the whole GLSL compilation
+    m_cacheable = useCache && ProgramCache::isSupported();
+    m_cacheKey = m_cacheable ? ProgramCache::key(vertexCode, fragmentCode) : 0;
+    m_fromBinary = m_cacheable && ProgramCache::load(m_building, m_cacheKey);
+    if (m_fromBinary) {
+        // Kept in case the driver rejects the binary
+        m_vertexCode = vertexCode;
+        m_fragmentCode = fragmentCode;
+        return;
     }
 
+    submitSources(vertexCode, fragmentCode);
+}
+
+void Shader::submitSources(const std::string& vertexCode, const std::string& fragmentCode) {
     const char* vShaderCode = vertexCode.c_str();
     const char* fShaderCode = fragmentCode.c_str();
 
-    // Compile shaders
-    unsigned int vertex, fragment;
-
-    vertex = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex, 1, &vShaderCode, NULL);
-    glCompileShader(vertex);
-    checkCompileErrors(vertex, "VERTEX");
+    // Compile shaders, the status is only queried once the driver is done
+    m_vertex = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(m_vertex, 1, &vShaderCode, NULL);
+    glCompileShader(m_vertex);
 
-    fragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment, 1, &fShaderCode, NULL);
-    glCompileShader(fragment);
-    checkCompileErrors(fragment, "FRAGMENT");
+    m_fragment = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(m_fragment, 1, &fShaderCode, NULL);
+    glCompileShader(m_fragment);
 
     // shader Program
-    ID = glCreateProgram();
-    glAttachShader(ID, vertex);
-    glAttachShader(ID, fragment);
-    glLinkProgram(ID);
-    checkCompileErrors(ID, "PROGRAM");
+    glAttachShader(m_building, m_vertex);
+    glAttachShader(m_building, m_fragment);
+    if (m_cacheable) {
+        glProgramParameteri(m_building, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    glLinkProgram(m_building);
+}
+
+bool Shader::isReady() {
+    if (m_building != 0) {
+        poll();
+    }
+    if (m_status == PENDING) {
+        s_frameStats.pendingPrograms++;
+    }
+    return m_status == READY;
+}
 
-    // delete the shaders as they're linked into our program now and no longer necessary
-    glDeleteShader(vertex);
-    glDeleteShader(fragment);
+void Shader::poll() {
+    // Without the extension the query below blocks, which is fine since every program has been submitted
+    if (parallelCompileSupported()) {
+        GLint completed = GL_FALSE;
+        glGetProgramiv(m_building, GL_COMPLETION_STATUS_KHR, &completed);
+        if (!completed) {
+            return;
+        }
+    }
 
+    if (m_fromBinary) {
+        m_fromBinary = false;
+        if (!ProgramCache::validate(m_building, m_cacheKey)) {
+            submitSources(m_vertexCode, m_fragmentCode);
+            return;
+        }
+    } else {
+        checkCompileErrors(m_vertex, "VERTEX");
+        checkCompileErrors(m_fragment, "FRAGMENT");
+        int success = checkCompileErrors(m_building, "PROGRAM");
+        if (success && m_cacheable) {
+            ProgramCache::store(m_building, m_cacheKey);
+        }
+
+        // delete the shaders as they're linked into our program now and no longer necessary
+        glDetachShader(m_building, m_vertex);
+        glDetachShader(m_building, m_fragment);
+        glDeleteShader(m_vertex);
+        glDeleteShader(m_fragment);
+
+        if (!success) {
+            // A broken edit must not leave the scene without a program
+            glDeleteProgram(m_building);
+            m_building = 0;
+            if (ID != 0) {
+                logger.warn("SHADER::RELOAD_FAILED keeping the previous program of " + std::string(vertexPath));
+            }
+            finish(ID != 0 ? READY : FAILED);
+            return;
+        }
+    }
 
+    // Swap the new program in only now that it's known to be valid
+    if (ID != 0) {
+        if (s_boundProgram == ID) {
+            s_boundProgram = 0;
+        }
+        glDeleteProgram(ID);
+    }
+    ID = m_building;
+    m_building = 0;
+
+    reflectUniforms();
+    reflectInterface();
+
+    // Programs reading the camera data get it from the shared per frame buffer
+    for (const UniformBlockInfo& block : m_uniformBlocks) {
+        if (block.name != "FrameData") {
+            continue;
+        }
+        if (block.size != sizeof(FrameData)) {
+            logger.error("SHADER::UNIFORM_BLOCK_MISMATCH FrameData is " + std::to_string(block.size) + " bytes in "
+                         + std::string(vertexPath) + ", " + std::to_string(sizeof(FrameData)) + " expected");
+        }
+        glUniformBlockBinding(ID, block.index, FrameData::BINDING);
+    }
+
+    finish(READY);
+}
+
+void Shader::finish(Status status) {
+    m_status = status;
+    m_vertexCode.clear();
+    m_fragmentCode.clear();
+
+    // Warm when every program came from the binary cache, cold otherwise
+    if (--s_pending == 0 && s_batchRunning) {
+        s_batchRunning = false;
+        double time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - s_batchStart).count();
+        logger.log(std::string(ProgramCache::getMisses() == 0 ? "Warm" : "Cold") + " shader init took " + std::to_string(time) + " ms ("
+                   + std::to_string(ProgramCache::getHits()) + " cached, " + std::to_string(ProgramCache::getMisses()) + " compiled)");
+    }
+}
+
+bool Shader::parallelCompileSupported() {
+    static const bool supported = [] {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count; i++) {
+            const char* name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+            if (std::strcmp(name, "GL_KHR_parallel_shader_compile") == 0 || std::strcmp(name, "GL_ARB_parallel_shader_compile") == 0) {
+                return true;
+            }
+        }
+        return false;
+    }();
+    return supported;
+}
+
+void Shader::reflectUniforms() {
+    m_uniforms.clear();
+
+    GLint count = 0, maxLength = 0;
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+    std::vector<char> buffer(maxLength > 0 ? maxLength : 1);
+    for (GLint i = 0; i < count; i++) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(ID, i, maxLength, &length, &size, &type, buffer.data());
+        std::string name(buffer.data(), length);
+
+        // Uniforms living in a uniform block don't have a location
+        GLint location = glGetUniformLocation(ID, name.c_str());
+        s_frameStats.driverLookups++;
+        if (location == -1) {
+            continue;
+        }
+
+        registerUniform({ name, location, type, size });
+
+        // Arrays are reported once as "name[0]", register the bare name and every element
+        if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0) {
+            std::string base = name.substr(0, name.size() - 3);
+            if (!m_uniforms.alias(base, static_cast<int>(m_uniforms.getUniforms().size() - 1))) {
+                logger.error("SHADER::UNIFORM_HASH_COLLISION on [" + base + "] in " + std::string(vertexPath));
+            }
+            for (GLint element = 1; element < size; element++) {
+                std::string elementName = base + "[" + std::to_string(element) + "]";
+                GLint elementLocation = glGetUniformLocation(ID, elementName.c_str());
+                s_frameStats.driverLookups++;
+                registerUniform({ elementName, elementLocation, type, 1 });
+            }
+        }
+    }
+
+    // A freshly linked program holds default values, forget everything uploaded before
+    m_shadows.assign(m_uniforms.getUniforms().size(), UniformShadow{});
+}
+
+void Shader::reflectInterface() {
+    m_attributes.clear();
+    m_uniformBlocks.clear();
+
+    GLint count = 0, maxLength = 0;
+    glGetProgramiv(ID, GL_ACTIVE_ATTRIBUTES, &count);
+    glGetProgramiv(ID, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxLength);
+
+    std::vector<char> buffer(maxLength > 0 ? maxLength : 1);
+    for (GLint i = 0; i < count; i++) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveAttrib(ID, i, maxLength, &length, &size, &type, buffer.data());
+        std::string name(buffer.data(), length);
+
+        // Built-ins like gl_VertexID aren't fed by a buffer
+        if (name.starts_with("gl_")) {
+            continue;
+        }
+        m_attributes.push_back({ name, glGetAttribLocation(ID, name.c_str()), type, size });
+    }
+    std::sort(m_attributes.begin(), m_attributes.end(), [](const AttributeInfo& a, const AttributeInfo& b) {
+        return a.location < b.location;
+    });
+
+    // Two programs with the same inputs at the same locations can share their vertex arrays
+    m_interfaceHash = fnv1a("");
+    for (const AttributeInfo& attribute : m_attributes) {
+        m_interfaceHash = fnv1a(attribute.name, m_interfaceHash);
+        m_interfaceHash = fnv1a(std::string_view(reinterpret_cast<const char*>(&attribute.location), sizeof(attribute.location)), m_interfaceHash);
+        m_interfaceHash = fnv1a(std::string_view(reinterpret_cast<const char*>(&attribute.type), sizeof(attribute.type)), m_interfaceHash);
+    }
+
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORM_BLOCKS, &count);
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxLength);
+    buffer.resize(maxLength > 0 ? maxLength : 1);
+    for (GLint i = 0; i < count; i++) {
+        GLsizei length = 0;
+        GLint size = 0;
+        glGetActiveUniformBlockName(ID, i, maxLength, &length, buffer.data());
+        glGetActiveUniformBlockiv(ID, i, GL_UNIFORM_BLOCK_DATA_SIZE, &size);
+        m_uniformBlocks.push_back({ std::string(buffer.data(), length), static_cast<GLuint>(i), size });
+    }
+}
+
+void Shader::registerUniform(const UniformInfo& info) {
+    if (!m_uniforms.insert(info)) {
+        logger.error("SHADER::UNIFORM_HASH_COLLISION on [" + info.name + "] in " + std::string(vertexPath));
+    }
 }
 
 //Checks for successfull compilation of shader
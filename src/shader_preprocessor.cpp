@@ -0,0 +1,84 @@
+#include "headers/shader_preprocessor.hpp"
+#include "headers/hash.hpp"
+#include "headers/logger.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+bool ShaderPreprocessor::process(const std::string& path, const ShaderDefines& defines, std::string& output, std::vector<std::string>& dependencies) {
+    std::set<std::string> included;
+    output.clear();
+    dependencies.clear();
+    return include(path, &defines, output, dependencies, included);
+}
+
+uint64_t ShaderPreprocessor::permutationKey(const std::string& vertexPath, const std::string& fragmentPath, const ShaderDefines& defines) {
+    uint64_t hash = fnv1a(vertexPath);
+    hash = fnv1a(std::string_view("\0", 1), hash);
+    hash = fnv1a(fragmentPath, hash);
+    for (const auto& [name, value] : defines) {
+        hash = fnv1a(std::string_view("\0", 1), hash);
+        hash = fnv1a(name, hash);
+        hash = fnv1a("=", hash);
+        hash = fnv1a(value, hash);
+    }
+    return hash;
+}
+
+bool ShaderPreprocessor::include(const std::string& path, const ShaderDefines* defines, std::string& output,
+                                 std::vector<std::string>& dependencies, std::set<std::string>& included) {
+    std::string normalized = std::filesystem::path(path).lexically_normal().generic_string();
+    if (!included.insert(normalized).second) {
+        return true;
+    }
+
+    std::ifstream file(normalized);
+    if (!file.is_open()) {
+        logger.error("SHADER::FILE_NOT_SUCCESFULLY_READ " + normalized);
+        return false;
+    }
+
+    size_t sourceIndex = dependencies.size();
+    dependencies.push_back(normalized);
+    std::filesystem::path directory = std::filesystem::path(normalized).parent_path();
+
+    std::string line;
+    size_t lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+
+        size_t start = line.find_first_not_of(" \t");
+        std::string_view directive = start == std::string::npos ? std::string_view() : std::string_view(line).substr(start);
+
+        if (directive.starts_with("#include")) {
+            size_t open = line.find('"');
+            size_t close = open == std::string::npos ? open : line.find('"', open + 1);
+            if (close == std::string::npos) {
+                logger.error("SHADER::MALFORMED_INCLUDE " + normalized + ":" + std::to_string(lineNumber));
+                return false;
+            }
+
+            std::string target = (directory / line.substr(open + 1, close - open - 1)).generic_string();
+            output += "#line 1 " + std::to_string(dependencies.size()) + "\n";
+            if (!include(target, nullptr, output, dependencies, included)) {
+                return false;
+            }
+            output += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(sourceIndex) + "\n";
+            continue;
+        }
+
+        output += line;
+        output += '\n';
+
+        // The defines have to come after #version, which must be the first directive of the shader
+        if (defines && directive.starts_with("#version")) {
+            for (const auto& [name, value] : *defines) {
+                output += "#define " + name + (value.empty() ? "" : " " + value) + "\n";
+            }
+            output += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(sourceIndex) + "\n";
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,148 @@
+#include "headers/shader_watcher.hpp"
+#include "headers/logger.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <map>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    // Editors often write a file in several steps, wait for things to settle before reading it
+    constexpr auto DEBOUNCE = std::chrono::milliseconds(200);
+    constexpr int POLL_TIMEOUT_MS = 50;
+}
+
+ShaderWatcher::ShaderWatcher(const std::string& directory, const std::vector<Shader*>& shaders) : m_directory(directory) {
+    for (Shader* shader : shaders) {
+        m_watched.push_back({ shader, shader->getVertexPath(), shader->getFragmentPath(), shader->getDefines(), shader->getDependencies() });
+    }
+
+#ifdef __linux__
+    m_thread = std::thread(&ShaderWatcher::run, this);
+#else
+    logger.warn("SHADER_WATCHER::UNSUPPORTED_PLATFORM shaders won't be hot-reloaded");
+#endif
+}
+
+ShaderWatcher::~ShaderWatcher() {
+    m_running = false;
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+void ShaderWatcher::update() {
+    std::vector<Reload> reloads;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        reloads.swap(m_reloads);
+    }
+
+    for (Reload& reload : reloads) {
+        logger.log("Reloading " + std::string(reload.shader->getVertexPath()) + " / " + reload.shader->getFragmentPath());
+        reload.shader->reload(reload.vertexCode, reload.fragmentCode, reload.dependencies);
+    }
+}
+
+void ShaderWatcher::rebuild(const std::vector<std::string>& changed) {
+    for (Watched& watched : m_watched) {
+        bool affected = std::any_of(changed.begin(), changed.end(), [&](const std::string& path) {
+            return std::find(watched.dependencies.begin(), watched.dependencies.end(), path) != watched.dependencies.end();
+        });
+        if (!affected) {
+            continue;
+        }
+
+        Reload reload;
+        reload.shader = watched.shader;
+        std::vector<std::string> vertexDependencies, fragmentDependencies;
+        if (!ShaderPreprocessor::process(watched.vertexPath, watched.defines, reload.vertexCode, vertexDependencies)
+            || !ShaderPreprocessor::process(watched.fragmentPath, watched.defines, reload.fragmentCode, fragmentDependencies)) {
+            // Probably caught in the middle of a save, the next event will try again
+            continue;
+        }
+
+        reload.dependencies = vertexDependencies;
+        reload.dependencies.insert(reload.dependencies.end(), fragmentDependencies.begin(), fragmentDependencies.end());
+        watched.dependencies = reload.dependencies;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // A newer version of the same shader replaces the one not submitted yet
+        auto previous = std::find_if(m_reloads.begin(), m_reloads.end(), [&](const Reload& r) { return r.shader == reload.shader; });
+        if (previous != m_reloads.end()) {
+            *previous = std::move(reload);
+        } else {
+            m_reloads.push_back(std::move(reload));
+        }
+    }
+}
+
+#ifdef __linux__
+void ShaderWatcher::run() {
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd == -1) {
+        logger.error("SHADER_WATCHER::INOTIFY_INIT_FAILED shaders won't be hot-reloaded");
+        return;
+    }
+
+    // inotify isn't recursive, every sub directory needs its own watch
+    constexpr uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE;
+    std::map<int, std::string> directories;
+    std::error_code error;
+    std::vector<std::string> paths = { m_directory };
+    for (auto it = std::filesystem::recursive_directory_iterator(m_directory, error); !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error)) {
+        if (it->is_directory()) {
+            paths.push_back(it->path().generic_string());
+        }
+    }
+    for (const std::string& path : paths) {
+        int wd = inotify_add_watch(fd, path.c_str(), mask);
+        if (wd != -1) {
+            directories[wd] = path;
+        }
+    }
+
+    std::vector<std::string> changed;
+    auto lastEvent = std::chrono::steady_clock::now();
+    alignas(inotify_event) char buffer[4096];
+
+    while (m_running) {
+        pollfd descriptor{ fd, POLLIN, 0 };
+        if (poll(&descriptor, 1, POLL_TIMEOUT_MS) > 0) {
+            ssize_t length;
+            while ((length = read(fd, buffer, sizeof(buffer))) > 0) {
+                for (char* ptr = buffer; ptr < buffer + length;) {
+                    const inotify_event* event = reinterpret_cast<const inotify_event*>(ptr);
+                    ptr += sizeof(inotify_event) + event->len;
+
+                    auto directory = directories.find(event->wd);
+                    if (directory == directories.end() || event->len == 0) {
+                        continue;
+                    }
+
+                    std::string path = (std::filesystem::path(directory->second) / event->name).lexically_normal().generic_string();
+                    if (std::find(changed.begin(), changed.end(), path) == changed.end()) {
+                        changed.push_back(path);
+                    }
+                    lastEvent = std::chrono::steady_clock::now();
+                }
+            }
+        }
+
+        if (!changed.empty() && std::chrono::steady_clock::now() - lastEvent >= DEBOUNCE) {
+            rebuild(changed);
+            changed.clear();
+        }
+    }
+
+    close(fd);
+}
+#else
+void ShaderWatcher::run() {}
+#endif
@@ -1,86 +1,575 @@
 #include "headers/texture.hpp"
+#include "headers/texture_cache.hpp"
+#include "headers/texture_container.hpp"
+#include "headers/texture_disk_cache.hpp"
+#include "headers/mip_generator.hpp"
+#include "headers/half_float.hpp"
 #include "headers/logger.hpp"
+#include "headers/thread_pool.hpp"
 
-std::map<std::string, Texture> Texture::m_map;
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <future>
 
-Texture::Texture() {}
-
-Texture::Texture(std::string filename, aiTextureType texture_type, bool flipTexture) {
-    int width, height, channels;
+std::mutex Texture::s_uploadsMutex;
+std::vector<Texture::PendingUpload> Texture::s_uploads;
+GLuint Texture::s_pixelBuffer = 0;
+size_t Texture::s_loading = 0;
+std::chrono::steady_clock::time_point Texture::s_loadStart;
+std::vector<uint32_t> Texture::s_streaming;
+std::array<Texture::Binding, Texture::TRACKED_UNITS> Texture::s_bindings;
+GLuint Texture::s_activeUnit = 0;
+TextureStats Texture::s_frameStats;
 
-    stbi_set_flip_vertically_on_load(flipTexture);
-    unsigned char *data = stbi_load(filename.c_str(), &width, &height, &channels, 0);
+namespace {
+    // Levels up to this size are uploaded as soon as the image is decoded, the larger ones are streamed on demand
+    constexpr int TAIL_SIZE = 64;
 
-    if (data == nullptr) {
-        logger.error("Failed to load texture: " + filename);
+    /**
+     * @brief Immutable storage needs a sized internal format, decoded images only give the number of channels
+     */
+    GLenum sizedFormat(const TextureImage& image) {
+        if (image.compressed) {
+            return image.internalFormat;
+        }
+        const GLenum bytes[] = { GL_R8, GL_RG8, GL_RGB8, GL_RGBA8 };
+        const GLenum halves[] = { GL_R16F, GL_RG16F, GL_RGB16F, GL_RGBA16F };
+        const GLenum floats[] = { GL_R32F, GL_RG32F, GL_RGB32F, GL_RGBA32F };
+        int index;
+        switch (image.internalFormat) {
+        case GL_RED: index = 0; break;
+        case GL_RG: index = 1; break;
+        case GL_RGB: index = 2; break;
+        case GL_RGBA: index = 3; break;
+        default: return image.internalFormat;
+        }
+        if (image.type == GL_HALF_FLOAT) {
+            return halves[index];
+        }
+        return image.type == GL_FLOAT ? floats[index] : bytes[index];
     }
+}
 
-    GLenum channels_type = 0;
-    if (channels == 1) {
-        channels_type = GL_RED;
-    } else if (channels == 3) {
-        channels_type = GL_RGB;
-    } else if (channels == 4) {
-        channels_type = GL_RGBA;
-    }
+Texture::Texture() {}
 
+Texture::Texture(std::string filename, aiTextureType texture_type, bool flipTexture, uint32_t cacheId) {
     glGenTextures(1, &this->m_ID);
-    glBindTexture(GL_TEXTURE_2D, this->m_ID);
+    bind(0, GL_TEXTURE_2D, this->m_ID);
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-    glTexImage2D(GL_TEXTURE_2D, 0, channels_type, width, height, 0, channels_type, GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
+    // Grey placeholder, sampled until the real image is uploaded
+    const unsigned char placeholder[4] = { 128, 128, 128, 255 };
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, placeholder);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
 
     this->m_filename = filename;
     this->m_texture_type = texture_type;
+    this->m_cacheId = cacheId;
+
+    // The loader threads can't query the driver themselves
+    TextureContainer::querySupport();
+
+    if (s_loading++ == 0) {
+        s_loadStart = std::chrono::steady_clock::now();
+    }
+
+    // Color maps are authored in sRGB, their mips are filtered in linear space
+    MipGenerator::Options mips;
+    mips.srgb = texture_type == aiTextureType_DIFFUSE || texture_type == aiTextureType_BASE_COLOR || texture_type == aiTextureType_EMISSIVE
+             || texture_type == aiTextureType_AMBIENT;
+
+    ThreadPool::loaders().submit([cacheId, filename, flipTexture, mips]() {
+        PendingUpload pending{ cacheId, {} };
+        if (!decode(filename, flipTexture, mips, pending.image)) {
+            logger.error("Failed to load texture: " + filename);
+            // Queued anyway without any level, the GL thread still has to account for it
+            pending.image = {};
+        }
+
+        std::lock_guard<std::mutex> lock(s_uploadsMutex);
+        s_uploads.push_back(std::move(pending));
+    });
+}
+
+bool Texture::decode(const std::string& filename, bool flipTextures, const MipGenerator::Options& mips, TextureImage& image) {
+    if (TextureContainer::isContainer(filename)) {
+        return decodeContainer(filename, flipTextures, image);
+    }
+
+    // Prefer the mip chain written by texture-cook, the image is read instead while the cooked file is stale or filtered differently
+    if (TextureContainer::isCooked(filename, mips) && decodeContainer(TextureContainer::cookedPath(filename), flipTextures, image)) {
+        return true;
+    }
+
+    // The source is read once, its bytes key the disk cache and stb decodes them on a miss
+    MappedFile source(filename);
+    if (!source.isOpen()) {
+        return false;
+    }
+    // HDR images are kept as half floats, their entries can't be shared with the 8 bits images stb used to give
+    bool hdr = stbi_is_hdr_from_memory(source.data(), static_cast<int>(source.size()));
+    uint64_t key = TextureDiskCache::key(source.data(), source.size(),
+                                         std::string(hdr ? "hdr;" : "") + (flipTextures ? "flip;" : "noflip;") + MipGenerator::describe(mips));
+    if (TextureDiskCache::load(key, image)) {
+        return true;
+    }
+
+    stbi_set_flip_vertically_on_load_thread(flipTextures);
+    void *data;
+    if (hdr) {
+        data = stbi_loadf_from_memory(source.data(), static_cast<int>(source.size()), &image.width, &image.height, &image.channels, 0);
+    } else {
+        data = stbi_load_from_memory(source.data(), static_cast<int>(source.size()), &image.width, &image.height, &image.channels, 0);
+    }
+
+    if (data == nullptr) {
+        return false;
+    }
+
+    if (image.channels == 1) {
+        image.format = GL_RED;
+    } else if (image.channels == 2) {
+        image.format = GL_RG;
+    } else if (image.channels == 3) {
+        image.format = GL_RGB;
+    } else {
+        image.format = GL_RGBA;
+    }
+    image.internalFormat = image.format;
+    image.type = hdr ? GL_FLOAT : GL_UNSIGNED_BYTE;
+    image.compressed = false;
+
+    size_t size = static_cast<size_t>(image.width) * image.height * image.channels * (hdr ? sizeof(float) : 1);
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    image.pixels.assign(bytes, bytes + size);
+    image.levels = { { 0, size, image.width, image.height } };
 
     stbi_image_free(data);
+
+    // Built here so the GL thread only uploads, glGenerateMipmap is only left as a fallback
+    MipGenerator::generate(image, mips);
+    if (hdr) {
+        toHalfFloats(image);
+    }
+    TextureDiskCache::store(key, image);
+
+    // The levels are kept until they're streamed in, the mapped entry can be paged out while the copy can't
+    TextureImage mapped;
+    if (TextureDiskCache::map(key, mapped)) {
+        image = std::move(mapped);
+    }
+    return true;
 }
 
-Texture Texture::loadCubemap(std::vector<std::string> paths) {
+bool Texture::decodeContainer(const std::string& filename, bool flipTextures, TextureImage& image) {
+    if (!TextureContainer::load(filename, image)) {
+        return false;
+    }
+    if (flipTextures && !TextureContainer::flipVertically(image)) {
+        logger.error("Can't flip texture: " + filename);
+        return false;
+    }
+    if (!TextureContainer::isSupported(image.internalFormat) && TextureContainer::decompress(image)) {
+        logger.warn("Compressed format not supported by the driver, decoded on the CPU: " + filename);
+    }
+    return true;
+}
+
+void Texture::processUploads(size_t budgetBytes) {
+    std::vector<PendingUpload> uploads;
+    {
+        std::lock_guard<std::mutex> lock(s_uploadsMutex);
+        uploads = std::move(s_uploads);
+        s_uploads.clear();
+    }
+
+    // Smallest levels first, they're tiny and give a low resolution texture within a few frames
+    size_t spent = 0;
+    for (PendingUpload& pending : uploads) {
+        // The texture may have been evicted while it was decoded
+        Texture* texture = TextureCache::find(pending.cacheId);
+        if (texture != nullptr && !pending.image.levels.empty()) {
+            spent += texture->allocate(std::move(pending.image));
+            TextureCache::setResidentBytes(pending.cacheId, texture->residentBytes());
+        }
+        finishLoad();
+    }
+
+    // Pointers are only valid until the cache evicts something
+    std::vector<Texture*> streaming;
+    auto collect = [&streaming]() {
+        streaming.clear();
+        s_streaming.erase(std::remove_if(s_streaming.begin(), s_streaming.end(), [&streaming](uint32_t cacheId) {
+            Texture* texture = TextureCache::find(cacheId);
+            if (texture != nullptr) {
+                streaming.push_back(texture);
+            }
+            return texture == nullptr;
+        }), s_streaming.end());
+    };
+    collect();
+
+    // Then one larger level at a time, the textures missing the most levels first
+    bool progress = true;
+    while (progress && (spent == 0 || spent < budgetBytes)) {
+        progress = false;
+        std::sort(streaming.begin(), streaming.end(), [](const Texture* a, const Texture* b) {
+            return a->m_baseLevel - a->getWantedLevel() > b->m_baseLevel - b->getWantedLevel();
+        });
+        for (Texture* texture : streaming) {
+            if (texture->getWantedLevel() >= texture->m_baseLevel || (spent != 0 && spent >= budgetBytes)) {
+                break;
+            }
+
+            GLint level = texture->m_baseLevel - 1;
+            bind(0, GL_TEXTURE_2D, texture->m_ID);
+            if (level < texture->m_uploadedLevel) {
+                spent += texture->m_levelBytes[level];
+                texture->upload(level, level + 1);
+            }
+            texture->setBaseLevel(level);
+            TextureCache::setResidentBytes(texture->m_cacheId, texture->residentBytes());
+            progress = true;
+        }
+    }
+
+    // Over budget with every unreferenced texture gone, the levels nobody needs are dropped, then the largest ones
+    TextureCache::evict();
+    collect();
+    std::sort(streaming.begin(), streaming.end(), [](const Texture* a, const Texture* b) {
+        return (a->m_demand == 0.0f) != (b->m_demand == 0.0f) ? a->m_demand == 0.0f : a->residentBytes() > b->residentBytes();
+    });
+    for (Texture* texture : streaming) {
+        if (!TextureCache::isOverBudget()) {
+            break;
+        }
+        GLint level = texture->m_requested && texture->m_demand == 0.0f ? texture->m_tailLevel : std::min(texture->getWantedLevel(), texture->m_tailLevel);
+        if (level > texture->m_baseLevel) {
+            bind(0, GL_TEXTURE_2D, texture->m_ID);
+            texture->setBaseLevel(level);
+            TextureCache::setResidentBytes(texture->m_cacheId, texture->residentBytes());
+        }
+    }
+
+    for (Texture* texture : streaming) {
+        texture->m_demand = 0.0f;
+    }
+}
+
+void Texture::finishLoad() {
+    // Warm when every decoded image came from the disk cache, cold otherwise
+    if (--s_loading == 0) {
+        double time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - s_loadStart).count();
+        logger.log(std::string(TextureDiskCache::getMisses() == 0 ? "Warm" : "Cold") + " texture load took " + std::to_string(time) + " ms ("
+                   + std::to_string(TextureDiskCache::getHits()) + " cached, " + std::to_string(TextureDiskCache::getMisses()) + " decoded)");
+    }
+}
+
+size_t Texture::getPendingUploads() {
+    std::lock_guard<std::mutex> lock(s_uploadsMutex);
+    return s_uploads.size();
+}
+
+size_t Texture::getMissingLevels() {
+    size_t missing = 0;
+    for (uint32_t cacheId : s_streaming) {
+        if (Texture* texture = TextureCache::find(cacheId)) {
+            missing += std::max(texture->m_baseLevel - texture->getWantedLevel(), 0);
+        }
+    }
+    return missing;
+}
+
+void Texture::request(float pixels) {
+    m_demand = std::max(m_demand, pixels);
+    m_requested = true;
+}
+
+size_t Texture::allocate(TextureImage&& image) {
+    m_image = std::move(image);
+    GLint imageLevels = static_cast<GLint>(m_image.levels.size());
+    // Images without a chain get one from the driver
+    bool generate = imageLevels == 1 && !m_image.compressed;
+    m_levels = generate ? static_cast<GLint>(std::floor(std::log2(std::max(m_image.width, m_image.height)))) + 1 : imageLevels;
+    m_width = m_image.width;
+    m_height = m_image.height;
+
+    m_levelBytes.clear();
+    for (GLint i = 0; i < m_levels; i++) {
+        if (i < imageLevels) {
+            m_levelBytes.push_back(m_image.levels[i].size);
+        } else {
+            // Generated levels keep the texel size of the base level
+            size_t texels = static_cast<size_t>(std::max(1, m_width >> i)) * std::max(1, m_height >> i);
+            m_levelBytes.push_back(texels * m_image.levels[0].size / (static_cast<size_t>(m_width) * m_height));
+        }
+    }
 
+    GLuint texture;
+    glGenTextures(1, &texture);
+    bind(0, GL_TEXTURE_2D, texture);
+    glTexStorage2D(GL_TEXTURE_2D, m_levels, sizedFormat(m_image), m_width, m_height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, m_levels - 1);
+
+    unbind(m_ID);
+    glDeleteTextures(1, &m_ID);
+    m_ID = texture;
+
+    m_tailLevel = 0;
+    if (!generate) {
+        m_tailLevel = imageLevels - 1;
+        while (m_tailLevel > 0 && std::max(m_image.levels[m_tailLevel - 1].width, m_image.levels[m_tailLevel - 1].height) <= TAIL_SIZE) {
+            m_tailLevel--;
+        }
+    }
+
+    size_t bytes = 0;
+    for (GLint i = m_tailLevel; i < imageLevels; i++) {
+        bytes += m_levelBytes[i];
+    }
+
+    m_uploadedLevel = m_levels;
+    upload(m_tailLevel, imageLevels);
+    if (generate) {
+        glGenerateMipmap(GL_TEXTURE_2D);
+    }
+    setBaseLevel(m_tailLevel);
+
+    if (m_levels > 1) {
+        s_streaming.push_back(m_cacheId);
+    }
+    return bytes;
+}
+
+void Texture::upload(GLint first, GLint last) {
+    if (s_pixelBuffer == 0) {
+        glGenBuffers(1, &s_pixelBuffer);
+    }
+
+    // The levels are stored back to back, the range is a single copy
+    size_t begin = m_image.levels[first].offset;
+    size_t size = m_image.levels[last - 1].offset + m_image.levels[last - 1].size - begin;
+
+    // Orphaning the buffer lets the driver keep the previous upload in flight
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, s_pixelBuffer);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+    void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (mapped == nullptr) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        logger.error("Failed to map the pixel buffer for texture " + m_filename);
+        return;
+    }
+    // Cached images are copied straight from their mapped entry
+    std::memcpy(mapped, m_image.data() + begin, size);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+    // Rows of 1 and 3 channels images aren't 4 bytes aligned
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (GLint i = first; i < last; i++) {
+        const TextureLevel& level = m_image.levels[i];
+        const void* offset = reinterpret_cast<const void*>(level.offset - begin);
+        if (m_image.compressed) {
+            glCompressedTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, level.width, level.height, m_image.internalFormat, static_cast<GLsizei>(level.size), offset);
+        } else {
+            glTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, level.width, level.height, m_image.format, m_image.type, offset);
+        }
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    m_uploadedLevel = std::min(m_uploadedLevel, first);
+    if (m_uploadedLevel == 0) {
+        // Everything is in VRAM, dropped levels come back by lowering the base level
+        m_image = {};
+    }
+}
+
+void Texture::bind(GLuint unit, GLenum target, GLuint texture) {
+    // The unit is made active even when the bind is skipped, glTexParameter* calls that follow apply to it
+    if (unit != s_activeUnit) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        s_activeUnit = unit;
+    }
+
+    if (unit < TRACKED_UNITS && s_bindings[unit].target == target && s_bindings[unit].texture == texture) {
+        s_frameStats.skippedBinds++;
+        return;
+    }
+    glBindTexture(target, texture);
+    if (unit < TRACKED_UNITS) {
+        s_bindings[unit] = { target, texture };
+    }
+    s_frameStats.issuedBinds++;
+}
+
+void Texture::unbind(GLuint texture) {
+    for (Binding& binding : s_bindings) {
+        if (binding.texture == texture) {
+            binding = {};
+        }
+    }
+}
+
+void Texture::setBaseLevel(GLint level) {
+    m_baseLevel = level;
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+}
+
+GLint Texture::getWantedLevel() const {
+    if (!m_requested) {
+        return 0;
+    }
+    if (m_demand <= 0.0f || m_levels == 0) {
+        return m_baseLevel;
+    }
+    // One texel per pixel across the object, the texture is assumed to cover it once
+    float ratio = static_cast<float>(std::max(m_width, m_height)) / m_demand;
+    GLint level = ratio > 1.0f ? static_cast<GLint>(std::floor(std::log2(ratio))) : 0;
+    return std::clamp(level, 0, m_levels - 1);
+}
+
+size_t Texture::residentBytes() const {
+    size_t bytes = 0;
+    for (GLint i = m_baseLevel; i < m_levels; i++) {
+        bytes += m_levelBytes[i];
+    }
+    return bytes;
+}
+
+void Texture::destroy() {
+    unbind(m_ID);
+    glDeleteTextures(1, &m_ID);
+    m_ID = 0;
+}
+
+Texture Texture::loadCubemap(std::vector<std::string> paths) {
     Texture t;
-    stbi_set_flip_vertically_on_load(false);
-    glGenTextures(1, &t.m_ID);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, t.m_ID);
+    t.m_ID = 0;
+    if (paths.size() != 6) {
+        logger.error("A cubemap needs 6 faces, " + std::to_string(paths.size()) + " given");
+        return t;
+    }
 
-    int width, height, nrChannels;
+    // The faces are independent, the load takes about as long as the slowest one
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::future<bool>> decoding;
+    std::vector<TextureImage> faces(paths.size());
     for (size_t i = 0; i < paths.size(); i++) {
-        unsigned char *data = stbi_load(paths[i].c_str(), &width, &height, &nrChannels, 0);
+        decoding.push_back(ThreadPool::loaders().submit([&path = paths[i], &face = faces[i]]() {
+            return decodeFace(path, face);
+        }));
+    }
 
-        if (data == nullptr) {
-            stbi_image_free(data);
+    bool valid = true;
+    for (size_t i = 0; i < paths.size(); i++) {
+        if (!decoding[i].get()) {
             logger.error("Failed to load texture: " + paths[i]);
-            break;
+            valid = false;
         }
+    }
+    if (!valid) {
+        return t;
+    }
 
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-        stbi_image_free(data);
+    // Every face shares the storage of the texture, nothing is uploaded unless they all match
+    const TextureImage& first = faces[0];
+    for (size_t i = 1; i < faces.size(); i++) {
+        if (faces[i].width != first.width || faces[i].height != first.height || faces[i].channels != first.channels
+            || faces[i].type != first.type) {
+            logger.error("Cubemap face " + paths[i] + " doesn't match the size or the format of " + paths[0]);
+            return t;
+        }
+    }
+    if (first.width != first.height) {
+        logger.error("Cubemap faces must be square, " + paths[0] + " is " + std::to_string(first.width) + "x" + std::to_string(first.height));
+        return t;
     }
 
+    // HDR faces are decoded to half floats, enough for radiance and half the VRAM of 32F
+    GLenum internalFormat = sizedFormat(first);
+
+    glGenTextures(1, &t.m_ID);
+    bind(0, GL_TEXTURE_CUBE_MAP, t.m_ID);
+    glTexStorage2D(GL_TEXTURE_CUBE_MAP, 1, internalFormat, first.width, first.height);
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (size_t i = 0; i < faces.size(); i++) {
+        glTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + static_cast<GLenum>(i), 0, 0, 0, faces[i].width, faces[i].height,
+                        faces[i].format, faces[i].type, faces[i].data());
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    logger.log("Loaded cubemap " + paths[0] + " in " + std::to_string(elapsed.count()) + " ms");
     return t;
 }
 
-void Texture::loadTextureInMemory(std::string filename, aiTextureType texture_type, bool flipTextures) {
-    if (!m_map.count(filename)) {
-        Texture texture{filename, texture_type, flipTextures};
-        Texture::m_map.insert(std::make_pair(filename, texture));
+bool Texture::decodeFace(const std::string& filename, TextureImage& image) {
+    // Cubemaps are sampled with directions, their faces are never flipped
+    stbi_set_flip_vertically_on_load_thread(false);
+
+    void* data;
+    size_t componentSize;
+    if (stbi_is_hdr(filename.c_str())) {
+        data = stbi_loadf(filename.c_str(), &image.width, &image.height, &image.channels, 0);
+        image.type = GL_FLOAT;
+        componentSize = sizeof(float);
+    } else {
+        data = stbi_load(filename.c_str(), &image.width, &image.height, &image.channels, 0);
+        image.type = GL_UNSIGNED_BYTE;
+        componentSize = 1;
+    }
+    if (data == nullptr) {
+        return false;
+    }
+
+    const GLenum formats[] = { GL_RED, GL_RG, GL_RGB, GL_RGBA };
+    image.format = formats[image.channels - 1];
+    image.internalFormat = image.format;
+    image.compressed = false;
+
+    size_t size = static_cast<size_t>(image.width) * image.height * image.channels * componentSize;
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    image.pixels.assign(bytes, bytes + size);
+    image.levels = { { 0, size, image.width, image.height } };
+    stbi_image_free(data);
+
+    if (image.type == GL_FLOAT) {
+        toHalfFloats(image);
+    }
+    return true;
+}
+
+void Texture::toHalfFloats(TextureImage& image) {
+    std::vector<unsigned char> halves(image.byteSize() / 2);
+    for (TextureLevel& level : image.levels) {
+        HalfFloat::fromFloats(reinterpret_cast<const float*>(image.data() + level.offset), reinterpret_cast<uint16_t*>(halves.data() + level.offset / 2),
+                              level.size / sizeof(float));
+        level.offset /= 2;
+        level.size /= 2;
     }
+    image.pixels = std::move(halves);
+    image.mapping.reset();
+    image.type = GL_HALF_FLOAT;
 }
 
-Texture Texture::getTextureFromFile(std::string filename, aiTextureType texture_type, bool flipTextures) {
-    loadTextureInMemory(filename, texture_type, flipTextures);
-    return Texture::m_map.at(filename);
+TextureHandle Texture::getTextureFromFile(std::string filename, aiTextureType texture_type, bool flipTextures) {
+    return TextureCache::acquire(filename, texture_type, flipTextures);
 }
 
 aiTextureType Texture::getType() {
@@ -0,0 +1,305 @@
+#include "headers/texture_atlas.hpp"
+#include "headers/texture.hpp"
+#include "headers/texture_disk_cache.hpp"
+#include "headers/mip_generator.hpp"
+#include "headers/mapped_file.hpp"
+#include "headers/thread_pool.hpp"
+#include "headers/logger.hpp"
+
+#include <stb/stb_image.h>
+
+#include <algorithm>
+#include <cmath>
+#include <future>
+
+namespace {
+    // Packed images start and end on multiples of the footprint of a texel of the smallest level
+    constexpr int ALIGNMENT = 1 << (TextureAtlas::MAX_LEVELS - 1);
+
+    int alignUp(int value) {
+        return (value + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    }
+}
+
+TextureAtlas::TextureAtlas(GLsizei layerSize) : m_layerSize(layerSize) {}
+
+TextureAtlas::~TextureAtlas() {
+    if (m_ID != 0) {
+        Texture::unbind(m_ID);
+        glDeleteTextures(1, &m_ID);
+    }
+}
+
+uint32_t TextureAtlas::add(const std::string& filename, bool flipTextures, bool srgb) {
+    m_sources.push_back({ filename, flipTextures, srgb });
+    m_regions.emplace_back();
+    return static_cast<uint32_t>(m_sources.size() - 1);
+}
+
+bool TextureAtlas::build() {
+    GLsizei levels = std::min(MAX_LEVELS, static_cast<GLsizei>(std::log2(m_layerSize)) + 1);
+
+    std::vector<std::future<Image>> decoding;
+    for (const Source& source : m_sources) {
+        decoding.push_back(ThreadPool::loaders().submit([source, layerSize = m_layerSize, levels]() {
+            return decode(source, layerSize, levels);
+        }));
+    }
+
+    std::vector<Image> images;
+    for (std::future<Image>& future : decoding) {
+        images.push_back(future.get());
+    }
+
+    // Tallest first, the skyline stays flat when the images of a row have similar heights
+    std::vector<size_t> order(images.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&images](size_t a, size_t b) {
+        return images[a].height != images[b].height ? images[a].height > images[b].height : images[a].width > images[b].width;
+    });
+
+    struct Placement {
+        size_t image;
+        int x;
+        int y;
+        GLint layer;
+    };
+    std::vector<Placement> placements;
+    // A full layer has a single node at its top
+    std::vector<std::vector<SkylineNode>> skylines;
+    size_t packedTexels = 0;
+
+    for (size_t i : order) {
+        const Image& image = images[i];
+        if (image.width == 0) {
+            logger.error("Failed to load atlas texture: " + m_sources[i].filename);
+            continue;
+        }
+        if (image.padded.levels.empty()) {
+            logger.error("Atlas texture " + m_sources[i].filename + " is larger than a layer of " + std::to_string(m_layerSize) + " texels");
+            continue;
+        }
+
+        // Layer sized images can't have a gutter, they fill a layer of their own and never bleed
+        if (image.gutter == 0) {
+            skylines.push_back({ { 0, m_layerSize, m_layerSize } });
+            placements.push_back({ i, 0, 0, static_cast<GLint>(skylines.size() - 1) });
+            packedTexels += static_cast<size_t>(image.width) * image.height;
+            continue;
+        }
+
+        int width = image.padded.width;
+        int height = image.padded.height;
+
+        // Lowest position over every layer, a new layer is only opened when none has room
+        int bestLayer = -1, bestIndex = -1, bestX = 0, bestY = 0;
+        for (size_t layer = 0; layer < skylines.size(); layer++) {
+            int x, y;
+            int index = findPosition(skylines[layer], width, height, x, y);
+            if (index != -1 && (bestIndex == -1 || y < bestY)) {
+                bestLayer = static_cast<int>(layer);
+                bestIndex = index;
+                bestX = x;
+                bestY = y;
+            }
+        }
+        if (bestIndex == -1) {
+            skylines.push_back({ { 0, 0, m_layerSize } });
+            bestLayer = static_cast<int>(skylines.size() - 1);
+            bestIndex = 0;
+            bestX = 0;
+            bestY = 0;
+        }
+
+        place(skylines[bestLayer], bestIndex, bestX, bestY, width, height);
+        placements.push_back({ i, bestX, bestY, bestLayer });
+        packedTexels += static_cast<size_t>(image.width) * image.height;
+    }
+
+    if (placements.empty()) {
+        logger.error("Texture atlas has nothing to pack");
+        return false;
+    }
+
+    m_layers = static_cast<GLsizei>(skylines.size());
+
+    if (m_ID != 0) {
+        Texture::unbind(m_ID);
+        glDeleteTextures(1, &m_ID);
+    }
+    glGenTextures(1, &m_ID);
+    Texture::bind(0, GL_TEXTURE_2D_ARRAY, m_ID);
+    glTexStorage3D(GL_TEXTURE_2D_ARRAY, levels, GL_RGBA8, m_layerSize, m_layerSize, m_layers);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levels - 1);
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (const Placement& placement : placements) {
+        const Image& image = images[placement.image];
+        upload(image, placement.x, placement.y, placement.layer, levels);
+
+        float size = static_cast<float>(m_layerSize);
+        AtlasRegion& region = m_regions[placement.image];
+        region.layer = placement.layer;
+        region.rect = glm::vec4((placement.x + image.gutter) / size, (placement.y + image.gutter) / size,
+                                image.width / size, image.height / size);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    size_t layerTexels = static_cast<size_t>(m_layerSize) * m_layerSize;
+    logger.log("Packed " + std::to_string(placements.size()) + " textures in " + std::to_string(m_layers) + " atlas layers, "
+               + std::to_string(packedTexels * 100 / (layerTexels * m_layers)) + "% used");
+    return true;
+}
+
+void TextureAtlas::bind(GLuint unit) const {
+    Texture::bind(unit, GL_TEXTURE_2D_ARRAY, m_ID);
+}
+
+int TextureAtlas::findPosition(const std::vector<SkylineNode>& skyline, int width, int height, int& x, int& y) const {
+    int bestIndex = -1, bestWidth = 0;
+    for (size_t i = 0; i < skyline.size(); i++) {
+        int left = skyline[i].x;
+        if (left + width > m_layerSize) {
+            break;
+        }
+
+        // The rectangle rests on the highest node it spans
+        int top = 0, remaining = width;
+        for (size_t j = i; remaining > 0; j++) {
+            top = std::max(top, skyline[j].y);
+            remaining -= skyline[j].width;
+        }
+        if (top + height > m_layerSize) {
+            continue;
+        }
+
+        // Lowest first, then the narrowest node to leave the wide ones to larger images
+        if (bestIndex == -1 || top < y || (top == y && skyline[i].width < bestWidth)) {
+            bestIndex = static_cast<int>(i);
+            bestWidth = skyline[i].width;
+            x = left;
+            y = top;
+        }
+    }
+    return bestIndex;
+}
+
+void TextureAtlas::place(std::vector<SkylineNode>& skyline, int index, int x, int y, int width, int height) {
+    skyline.insert(skyline.begin() + index, { x, y + height, width });
+
+    // Shrink or remove the nodes now under the rectangle
+    for (size_t i = index + 1; i < skyline.size(); i++) {
+        SkylineNode& node = skyline[i];
+        int covered = x + width - node.x;
+        if (covered <= 0) {
+            break;
+        }
+        if (covered < node.width) {
+            node.x += covered;
+            node.width -= covered;
+            break;
+        }
+        skyline.erase(skyline.begin() + i);
+        i--;
+    }
+
+    // Neighbours at the same height are one node
+    for (size_t i = 0; i + 1 < skyline.size();) {
+        if (skyline[i].y == skyline[i + 1].y) {
+            skyline[i].width += skyline[i + 1].width;
+            skyline.erase(skyline.begin() + i + 1);
+        } else {
+            i++;
+        }
+    }
+}
+
+TextureAtlas::Image TextureAtlas::decode(const Source& source, GLsizei layerSize, GLsizei levels) {
+    Image image;
+    MappedFile file(source.filename);
+    int channels;
+    if (!file.isOpen() || !stbi_info_from_memory(file.data(), static_cast<int>(file.size()), &image.width, &image.height, &channels)) {
+        image.width = 0;
+        return image;
+    }
+
+    // Padded up to the alignment so every level lines up with the texels of the layer
+    image.gutter = image.width == layerSize && image.height == layerSize ? 0 : GUTTER;
+    int width = alignUp(image.width + 2 * image.gutter);
+    int height = alignUp(image.height + 2 * image.gutter);
+    if (width > layerSize || height > layerSize) {
+        return image;
+    }
+
+    // The gutter already clamps the edges, wrapping would filter in the opposite side
+    MipGenerator::Options mips;
+    mips.srgb = source.srgb;
+    mips.wrap = false;
+    uint64_t key = TextureDiskCache::key(file.data(), file.size(),
+                                         std::string("atlas;") + (source.flip ? "flip;" : "noflip;") + "gutter=" + std::to_string(image.gutter)
+                                         + ";levels=" + std::to_string(levels) + ";" + MipGenerator::describe(mips));
+    if (TextureDiskCache::load(key, image.padded)) {
+        return image;
+    }
+
+    stbi_set_flip_vertically_on_load_thread(source.flip);
+    // Every layer shares the format of the array, images are expanded to RGBA
+    int decodedWidth, decodedHeight;
+    unsigned char* data = stbi_load_from_memory(file.data(), static_cast<int>(file.size()), &decodedWidth, &decodedHeight, &channels, 4);
+    if (data == nullptr || decodedWidth != image.width || decodedHeight != image.height) {
+        stbi_image_free(data);
+        image.width = 0;
+        return image;
+    }
+
+    // The gutter repeats the closest edge texel, like GL_CLAMP_TO_EDGE would
+    TextureImage& padded = image.padded;
+    padded.width = width;
+    padded.height = height;
+    padded.channels = 4;
+    padded.internalFormat = GL_RGBA;
+    padded.format = GL_RGBA;
+    padded.type = GL_UNSIGNED_BYTE;
+    padded.pixels.resize(static_cast<size_t>(width) * height * 4);
+    padded.levels = { { 0, padded.pixels.size(), width, height } };
+    for (int row = 0; row < height; row++) {
+        int sourceRow = std::clamp(row - image.gutter, 0, image.height - 1);
+        const unsigned char* sourcePixels = data + static_cast<size_t>(sourceRow) * image.width * 4;
+        unsigned char* target = padded.pixels.data() + static_cast<size_t>(row) * width * 4;
+        for (int column = 0; column < width; column++) {
+            int sourceColumn = std::clamp(column - image.gutter, 0, image.width - 1);
+            std::copy_n(sourcePixels + sourceColumn * 4, 4, target + column * 4);
+        }
+    }
+    stbi_image_free(data);
+
+    // Filtered in linear space, only the levels of the texture array are kept
+    MipGenerator::generate(padded, mips);
+    if (padded.levels.size() > static_cast<size_t>(levels)) {
+        padded.levels.resize(levels);
+        padded.pixels.resize(padded.levels.back().offset + padded.levels.back().size);
+    }
+    TextureDiskCache::store(key, padded);
+
+    TextureImage mapped;
+    if (TextureDiskCache::map(key, mapped)) {
+        padded = std::move(mapped);
+    }
+    return image;
+}
+
+void TextureAtlas::upload(const Image& image, int x, int y, GLint layer, GLsizei levels) {
+    const TextureImage& padded = image.padded;
+    GLsizei count = std::min(levels, static_cast<GLsizei>(padded.levels.size()));
+    for (GLsizei i = 0; i < count; i++) {
+        const TextureLevel& level = padded.levels[i];
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, i, x >> i, y >> i, layer, level.width, level.height, 1, GL_RGBA, GL_UNSIGNED_BYTE,
+                        padded.data() + level.offset);
+    }
+}
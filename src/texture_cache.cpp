@@ -0,0 +1,143 @@
+#include "headers/texture_cache.hpp"
+#include "headers/logger.hpp"
+
+TextureHandle TextureCache::acquire(const std::string& filename, aiTextureType texture_type, bool flipTextures) {
+    uint32_t path = intern(filename);
+
+    auto it = s_entries.find(path);
+    if (it != s_entries.end()) {
+        s_hits++;
+    } else {
+        s_misses++;
+        Entry entry;
+        entry.texture = Texture{ filename, texture_type, flipTextures, path };
+        it = s_entries.emplace(path, std::move(entry)).first;
+    }
+
+    addReference(path);
+    return TextureHandle{ path };
+}
+
+void TextureCache::setBudget(size_t megabytes) {
+    s_budget = megabytes * 1024 * 1024;
+    evict();
+}
+
+TextureCache::Stats TextureCache::getStats() {
+    return { s_resident, s_budget, s_entries.size(), s_hits, s_misses, s_evictions };
+}
+
+uint32_t TextureCache::intern(const std::string& path) {
+    auto it = s_pathIds.find(path);
+    if (it != s_pathIds.end()) {
+        return it->second;
+    }
+
+    uint32_t id = static_cast<uint32_t>(s_paths.size());
+    s_paths.push_back(path);
+    s_pathIds.emplace(path, id);
+    return id;
+}
+
+const std::string& TextureCache::getPath(uint32_t path) {
+    return s_paths.at(path);
+}
+
+void TextureCache::addReference(uint32_t path) {
+    Entry& entry = s_entries.at(path);
+    if (entry.references++ == 0 && entry.evictable) {
+        s_lru.erase(entry.lru);
+        entry.evictable = false;
+    }
+}
+
+void TextureCache::release(uint32_t path) {
+    Entry& entry = s_entries.at(path);
+    if (--entry.references == 0) {
+        s_lru.push_front(path);
+        entry.lru = s_lru.begin();
+        entry.evictable = true;
+        evict();
+    }
+}
+
+aiTextureType TextureCache::getType(uint32_t path) {
+    return s_entries.at(path).texture.getType();
+}
+
+GLuint TextureCache::getID(uint32_t path) {
+    return s_entries.at(path).texture.getID();
+}
+
+Texture* TextureCache::find(uint32_t path) {
+    auto it = s_entries.find(path);
+    return it != s_entries.end() ? &it->second.texture : nullptr;
+}
+
+void TextureCache::setResidentBytes(uint32_t path, size_t bytes) {
+    Entry& entry = s_entries.at(path);
+    s_resident = s_resident - entry.bytes + bytes;
+    entry.bytes = bytes;
+}
+
+void TextureCache::evict() {
+    while (s_resident > s_budget && !s_lru.empty()) {
+        uint32_t path = s_lru.back();
+        s_lru.pop_back();
+
+        auto it = s_entries.find(path);
+        it->second.texture.destroy();
+        s_resident -= it->second.bytes;
+        s_entries.erase(it);
+        s_evictions++;
+    }
+}
+
+TextureHandle::TextureHandle(const TextureHandle& other) : m_path(other.m_path) {
+    if (isValid()) {
+        TextureCache::addReference(m_path);
+    }
+}
+
+TextureHandle::TextureHandle(TextureHandle&& other) noexcept : m_path(other.m_path) {
+    other.m_path = INVALID_PATH;
+}
+
+TextureHandle& TextureHandle::operator=(const TextureHandle& other) {
+    if (this != &other) {
+        TextureHandle copy(other);
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+TextureHandle& TextureHandle::operator=(TextureHandle&& other) noexcept {
+    if (this != &other) {
+        if (isValid()) {
+            TextureCache::release(m_path);
+        }
+        m_path = other.m_path;
+        other.m_path = INVALID_PATH;
+    }
+    return *this;
+}
+
+TextureHandle::~TextureHandle() {
+    if (isValid()) {
+        TextureCache::release(m_path);
+    }
+}
+
+GLuint TextureHandle::getID() const {
+    return isValid() ? TextureCache::getID(m_path) : 0;
+}
+
+aiTextureType TextureHandle::getType() const {
+    return TextureCache::getType(m_path);
+}
+
+void TextureHandle::request(float pixels) const {
+    if (isValid()) {
+        TextureCache::find(m_path)->request(pixels);
+    }
+}
@@ -0,0 +1,574 @@
+#include "headers/texture_container.hpp"
+#include "headers/cooked_path.hpp"
+#include "headers/cooked_texture.hpp"
+#include "headers/logger.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace {
+    constexpr unsigned char KTX2_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+    struct Ktx2Header {
+        unsigned char identifier[12];
+        uint32_t vkFormat;
+        uint32_t typeSize;
+        uint32_t pixelWidth;
+        uint32_t pixelHeight;
+        uint32_t pixelDepth;
+        uint32_t layerCount;
+        uint32_t faceCount;
+        uint32_t levelCount;
+        uint32_t supercompressionScheme;
+        uint32_t dfdByteOffset;
+        uint32_t dfdByteLength;
+        uint32_t kvdByteOffset;
+        uint32_t kvdByteLength;
+        uint64_t sgdByteOffset;
+        uint64_t sgdByteLength;
+    };
+    static_assert(sizeof(Ktx2Header) == 80, "KTX2 header must match the file layout");
+
+    struct Ktx2Level {
+        uint64_t byteOffset;
+        uint64_t byteLength;
+        uint64_t uncompressedByteLength;
+    };
+
+    struct DdsPixelFormat {
+        uint32_t size;
+        uint32_t flags;
+        uint32_t fourCC;
+        uint32_t rgbBitCount;
+        uint32_t masks[4];
+    };
+
+    struct DdsHeader {
+        uint32_t size;
+        uint32_t flags;
+        uint32_t height;
+        uint32_t width;
+        uint32_t pitchOrLinearSize;
+        uint32_t depth;
+        uint32_t mipMapCount;
+        uint32_t reserved1[11];
+        DdsPixelFormat pixelFormat;
+        uint32_t caps[4];
+        uint32_t reserved2;
+    };
+    static_assert(sizeof(DdsHeader) == 124, "DDS header must match the file layout");
+
+    struct DdsHeaderDx10 {
+        uint32_t dxgiFormat;
+        uint32_t resourceDimension;
+        uint32_t miscFlag;
+        uint32_t arraySize;
+        uint32_t miscFlags2;
+    };
+
+    constexpr uint32_t fourCC(const char (&code)[5]) {
+        return uint32_t(uint8_t(code[0])) | uint32_t(uint8_t(code[1])) << 8 | uint32_t(uint8_t(code[2])) << 16 | uint32_t(uint8_t(code[3])) << 24;
+    }
+
+    constexpr uint32_t DDS_MAGIC = fourCC("DDS ");
+    constexpr uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+    constexpr uint32_t DDPF_ALPHAPIXELS = 0x1;
+    constexpr uint32_t DDPF_FOURCC = 0x4;
+
+    struct FormatInfo {
+        GLenum internalFormat;
+        int channels;
+    };
+
+    FormatInfo fromVkFormat(uint32_t vkFormat) {
+        switch (vkFormat) {
+        case 131: return { GL_COMPRESSED_RGB_S3TC_DXT1_EXT, 3 };         // VK_FORMAT_BC1_RGB_UNORM_BLOCK
+        case 132: return { GL_COMPRESSED_SRGB_S3TC_DXT1_EXT, 3 };        // VK_FORMAT_BC1_RGB_SRGB_BLOCK
+        case 133: return { GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, 4 };        // VK_FORMAT_BC1_RGBA_UNORM_BLOCK
+        case 134: return { GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT, 4 };  // VK_FORMAT_BC1_RGBA_SRGB_BLOCK
+        case 135: return { GL_COMPRESSED_RGBA_S3TC_DXT3_EXT, 4 };        // VK_FORMAT_BC2_UNORM_BLOCK
+        case 136: return { GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT, 4 };  // VK_FORMAT_BC2_SRGB_BLOCK
+        case 137: return { GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, 4 };        // VK_FORMAT_BC3_UNORM_BLOCK
+        case 138: return { GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT, 4 };  // VK_FORMAT_BC3_SRGB_BLOCK
+        case 139: return { GL_COMPRESSED_RED_RGTC1, 1 };                 // VK_FORMAT_BC4_UNORM_BLOCK
+        case 140: return { GL_COMPRESSED_SIGNED_RED_RGTC1, 1 };          // VK_FORMAT_BC4_SNORM_BLOCK
+        case 141: return { GL_COMPRESSED_RG_RGTC2, 2 };                  // VK_FORMAT_BC5_UNORM_BLOCK
+        case 142: return { GL_COMPRESSED_SIGNED_RG_RGTC2, 2 };           // VK_FORMAT_BC5_SNORM_BLOCK
+        case 145: return { GL_COMPRESSED_RGBA_BPTC_UNORM, 4 };           // VK_FORMAT_BC7_UNORM_BLOCK
+        case 146: return { GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM, 4 };     // VK_FORMAT_BC7_SRGB_BLOCK
+        default: return { 0, 0 };
+        }
+    }
+
+    FormatInfo fromDxgiFormat(uint32_t dxgiFormat) {
+        switch (dxgiFormat) {
+        case 71: return { GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, 4 };         // DXGI_FORMAT_BC1_UNORM
+        case 72: return { GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT, 4 };   // DXGI_FORMAT_BC1_UNORM_SRGB
+        case 74: return { GL_COMPRESSED_RGBA_S3TC_DXT3_EXT, 4 };         // DXGI_FORMAT_BC2_UNORM
+        case 75: return { GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT, 4 };   // DXGI_FORMAT_BC2_UNORM_SRGB
+        case 77: return { GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, 4 };         // DXGI_FORMAT_BC3_UNORM
+        case 78: return { GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT, 4 };   // DXGI_FORMAT_BC3_UNORM_SRGB
+        case 80: return { GL_COMPRESSED_RED_RGTC1, 1 };                  // DXGI_FORMAT_BC4_UNORM
+        case 81: return { GL_COMPRESSED_SIGNED_RED_RGTC1, 1 };           // DXGI_FORMAT_BC4_SNORM
+        case 83: return { GL_COMPRESSED_RG_RGTC2, 2 };                   // DXGI_FORMAT_BC5_UNORM
+        case 84: return { GL_COMPRESSED_SIGNED_RG_RGTC2, 2 };            // DXGI_FORMAT_BC5_SNORM
+        case 98: return { GL_COMPRESSED_RGBA_BPTC_UNORM, 4 };            // DXGI_FORMAT_BC7_UNORM
+        case 99: return { GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM, 4 };      // DXGI_FORMAT_BC7_UNORM_SRGB
+        default: return { 0, 0 };
+        }
+    }
+
+    FormatInfo fromFourCC(uint32_t code, bool alpha) {
+        if (code == fourCC("DXT1")) {
+            return alpha ? FormatInfo{ GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, 4 } : FormatInfo{ GL_COMPRESSED_RGB_S3TC_DXT1_EXT, 3 };
+        } else if (code == fourCC("DXT2") || code == fourCC("DXT3")) {
+            return { GL_COMPRESSED_RGBA_S3TC_DXT3_EXT, 4 };
+        } else if (code == fourCC("DXT4") || code == fourCC("DXT5")) {
+            return { GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, 4 };
+        } else if (code == fourCC("ATI1") || code == fourCC("BC4U")) {
+            return { GL_COMPRESSED_RED_RGTC1, 1 };
+        } else if (code == fourCC("BC4S")) {
+            return { GL_COMPRESSED_SIGNED_RED_RGTC1, 1 };
+        } else if (code == fourCC("ATI2") || code == fourCC("BC5U")) {
+            return { GL_COMPRESSED_RG_RGTC2, 2 };
+        } else if (code == fourCC("BC5S")) {
+            return { GL_COMPRESSED_SIGNED_RG_RGTC2, 2 };
+        }
+        return { 0, 0 };
+    }
+
+    bool isS3tc(GLenum internalFormat) {
+        return (internalFormat >= GL_COMPRESSED_RGB_S3TC_DXT1_EXT && internalFormat <= GL_COMPRESSED_RGBA_S3TC_DXT5_EXT)
+            || (internalFormat >= GL_COMPRESSED_SRGB_S3TC_DXT1_EXT && internalFormat <= GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT);
+    }
+
+    bool isSrgb(GLenum internalFormat) {
+        return (internalFormat >= GL_COMPRESSED_SRGB_S3TC_DXT1_EXT && internalFormat <= GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT)
+            || internalFormat == GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM;
+    }
+
+    size_t blockBytes(GLenum internalFormat) {
+        switch (internalFormat) {
+        case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_RED_RGTC1:
+        case GL_COMPRESSED_SIGNED_RED_RGTC1:
+            return 8;
+        default:
+            return 16;
+        }
+    }
+
+    size_t levelSize(GLenum internalFormat, int width, int height) {
+        return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * blockBytes(internalFormat);
+    }
+
+    template <typename T>
+    bool read(const std::vector<unsigned char>& file, size_t offset, T& value) {
+        if (offset > file.size() || file.size() - offset < sizeof(T)) {
+            return false;
+        }
+        std::memcpy(&value, file.data() + offset, sizeof(T));
+        return true;
+    }
+
+    bool readFile(const std::string& filename, std::vector<unsigned char>& file) {
+        std::ifstream stream(filename, std::ios::binary | std::ios::ate);
+        if (!stream) {
+            return false;
+        }
+        file.resize(static_cast<size_t>(stream.tellg()));
+        stream.seekg(0);
+        return static_cast<bool>(stream.read(reinterpret_cast<char*>(file.data()), file.size()));
+    }
+
+    bool validSize(uint32_t width, uint32_t height) {
+        return width > 0 && height > 0 && width <= INT32_MAX && height <= INT32_MAX;
+    }
+
+    /**
+     * @brief Clamp the level count of a file to the levels of a full chain, the count only comes from the file
+     *
+     * Larger counts would shift the size past 32 bits and make the immutable storage fail.
+     */
+    uint32_t clampLevels(uint32_t levelCount, uint32_t width, uint32_t height) {
+        uint32_t fullChain = static_cast<uint32_t>(std::bit_width(std::max(width, height)));
+        return std::clamp(levelCount, 1u, fullChain);
+    }
+
+    /**
+     * @brief Append a level of the file to the image, checking it lies within the file
+     */
+    bool appendLevel(const std::vector<unsigned char>& file, size_t offset, int width, int height, TextureImage& image) {
+        size_t size = levelSize(image.internalFormat, width, height);
+        if (offset > file.size() || file.size() - offset < size) {
+            return false;
+        }
+        image.levels.push_back({ image.pixels.size(), size, width, height });
+        image.pixels.insert(image.pixels.end(), file.begin() + offset, file.begin() + offset + size);
+        return true;
+    }
+
+    void expand565(uint16_t color, unsigned char rgb[3]) {
+        rgb[0] = static_cast<unsigned char>(((color >> 11) & 31) * 255 / 31);
+        rgb[1] = static_cast<unsigned char>(((color >> 5) & 63) * 255 / 63);
+        rgb[2] = static_cast<unsigned char>((color & 31) * 255 / 31);
+    }
+
+    /**
+     * @brief Decode the color part of a BC1, BC2 or BC3 block in 16 RGBA texels
+     *
+     * @param opaque True for BC2 and BC3, whose color part always uses the four colors mode
+     */
+    void decodeColorBlock(const unsigned char* block, bool opaque, unsigned char texels[16][4]) {
+        uint16_t color0, color1;
+        std::memcpy(&color0, block, 2);
+        std::memcpy(&color1, block + 2, 2);
+
+        unsigned char palette[4][4];
+        expand565(color0, palette[0]);
+        expand565(color1, palette[1]);
+        palette[0][3] = palette[1][3] = 255;
+        for (int c = 0; c < 3; c++) {
+            if (opaque || color0 > color1) {
+                palette[2][c] = static_cast<unsigned char>((2 * palette[0][c] + palette[1][c]) / 3);
+                palette[3][c] = static_cast<unsigned char>((palette[0][c] + 2 * palette[1][c]) / 3);
+            } else {
+                palette[2][c] = static_cast<unsigned char>((palette[0][c] + palette[1][c]) / 2);
+                palette[3][c] = 0;
+            }
+        }
+        palette[2][3] = 255;
+        palette[3][3] = (opaque || color0 > color1) ? 255 : 0;
+
+        uint32_t indices;
+        std::memcpy(&indices, block + 4, 4);
+        for (int i = 0; i < 16; i++) {
+            std::memcpy(texels[i], palette[(indices >> (2 * i)) & 3], 4);
+        }
+    }
+
+    /**
+     * @brief Decode a BC3 alpha block in the alpha channel of 16 RGBA texels
+     */
+    void decodeAlphaBlock(const unsigned char* block, unsigned char texels[16][4]) {
+        unsigned int alpha[8] = { block[0], block[1] };
+        if (alpha[0] > alpha[1]) {
+            for (int i = 1; i < 7; i++) {
+                alpha[i + 1] = ((7 - i) * alpha[0] + i * alpha[1]) / 7;
+            }
+        } else {
+            for (int i = 1; i < 5; i++) {
+                alpha[i + 1] = ((5 - i) * alpha[0] + i * alpha[1]) / 5;
+            }
+            alpha[6] = 0;
+            alpha[7] = 255;
+        }
+
+        uint64_t indices = 0;
+        std::memcpy(&indices, block + 2, 6);
+        for (int i = 0; i < 16; i++) {
+            texels[i][3] = static_cast<unsigned char>(alpha[(indices >> (3 * i)) & 7]);
+        }
+    }
+}
+
+bool TextureContainer::isContainer(const std::string& filename) {
+    std::string extension = std::filesystem::path(filename).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return std::tolower(c); });
+    return extension == ".ktx2" || extension == ".dds";
+}
+
+bool TextureContainer::load(const std::string& filename, TextureImage& image) {
+    std::vector<unsigned char> file;
+    if (!readFile(filename, file)) {
+        logger.error("Failed to read texture container: " + filename);
+        return false;
+    }
+
+    if (file.size() >= sizeof(KTX2_IDENTIFIER) && std::memcmp(file.data(), KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) == 0) {
+        return loadKtx2(filename, file, image);
+    }
+
+    uint32_t magic = 0;
+    if (read(file, 0, magic) && magic == DDS_MAGIC) {
+        return loadDds(filename, file, image);
+    }
+
+    logger.error("Unknown texture container: " + filename);
+    return false;
+}
+
+bool TextureContainer::loadKtx2(const std::string& filename, const std::vector<unsigned char>& file, TextureImage& image) {
+    Ktx2Header header;
+    if (!read(file, 0, header)) {
+        logger.error("Truncated KTX2 header: " + filename);
+        return false;
+    }
+
+    if (header.supercompressionScheme != 0 || header.pixelDepth > 1 || header.layerCount > 1 || header.faceCount != 1) {
+        logger.error("Only uncompressed 2D KTX2 textures are supported: " + filename);
+        return false;
+    }
+
+    FormatInfo format = fromVkFormat(header.vkFormat);
+    if (format.internalFormat == 0) {
+        logger.error("Unsupported KTX2 format " + std::to_string(header.vkFormat) + ": " + filename);
+        return false;
+    }
+    if (!validSize(header.pixelWidth, header.pixelHeight)) {
+        logger.error("Invalid KTX2 size " + std::to_string(header.pixelWidth) + "x" + std::to_string(header.pixelHeight) + ": " + filename);
+        return false;
+    }
+
+    image.width = static_cast<int>(header.pixelWidth);
+    image.height = static_cast<int>(header.pixelHeight);
+    image.channels = format.channels;
+    image.internalFormat = format.internalFormat;
+    image.format = 0;
+    image.compressed = true;
+    image.levels.clear();
+    image.pixels.clear();
+
+    // A level count of 0 asks for mipmaps generated at load time, which isn't possible with compressed data
+    uint32_t levelCount = clampLevels(header.levelCount, header.pixelWidth, header.pixelHeight);
+    for (uint32_t i = 0; i < levelCount; i++) {
+        Ktx2Level level;
+        if (!read(file, sizeof(Ktx2Header) + i * sizeof(Ktx2Level), level)) {
+            logger.error("Truncated KTX2 level index: " + filename);
+            return false;
+        }
+
+        int width = std::max(1, image.width >> i);
+        int height = std::max(1, image.height >> i);
+        if (level.byteLength < levelSize(image.internalFormat, width, height)
+            || !appendLevel(file, static_cast<size_t>(level.byteOffset), width, height, image)) {
+            logger.error("Truncated KTX2 level " + std::to_string(i) + ": " + filename);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool TextureContainer::loadDds(const std::string& filename, const std::vector<unsigned char>& file, TextureImage& image) {
+    DdsHeader header;
+    if (!read(file, sizeof(uint32_t), header) || header.size != sizeof(DdsHeader)) {
+        logger.error("Invalid DDS header: " + filename);
+        return false;
+    }
+
+    size_t offset = sizeof(uint32_t) + sizeof(DdsHeader);
+    FormatInfo format{ 0, 0 };
+    if ((header.pixelFormat.flags & DDPF_FOURCC) && header.pixelFormat.fourCC == fourCC("DX10")) {
+        DdsHeaderDx10 dx10;
+        if (!read(file, offset, dx10)) {
+            logger.error("Truncated DDS header: " + filename);
+            return false;
+        }
+        if (dx10.arraySize > 1) {
+            logger.error("DDS texture arrays aren't supported: " + filename);
+            return false;
+        }
+        offset += sizeof(DdsHeaderDx10);
+        format = fromDxgiFormat(dx10.dxgiFormat);
+    } else if (header.pixelFormat.flags & DDPF_FOURCC) {
+        format = fromFourCC(header.pixelFormat.fourCC, header.pixelFormat.flags & DDPF_ALPHAPIXELS);
+    }
+
+    if (format.internalFormat == 0) {
+        logger.error("Unsupported DDS format: " + filename);
+        return false;
+    }
+    if (!validSize(header.width, header.height)) {
+        logger.error("Invalid DDS size " + std::to_string(header.width) + "x" + std::to_string(header.height) + ": " + filename);
+        return false;
+    }
+
+    image.width = static_cast<int>(header.width);
+    image.height = static_cast<int>(header.height);
+    image.channels = format.channels;
+    image.internalFormat = format.internalFormat;
+    image.format = 0;
+    image.compressed = true;
+    image.levels.clear();
+    image.pixels.clear();
+
+    uint32_t levelCount = (header.flags & DDSD_MIPMAPCOUNT) ? clampLevels(header.mipMapCount, header.width, header.height) : 1;
+    for (uint32_t i = 0; i < levelCount; i++) {
+        int width = std::max(1, image.width >> i);
+        int height = std::max(1, image.height >> i);
+        if (!appendLevel(file, offset, width, height, image)) {
+            logger.error("Truncated DDS level " + std::to_string(i) + ": " + filename);
+            return false;
+        }
+        offset += image.levels.back().size;
+    }
+    return true;
+}
+
+std::string TextureContainer::cookedPath(const std::string& filename) {
+    return ::cookedPath(filename, ".ktx2");
+}
+
+bool TextureContainer::isCooked(const std::string& filename, const MipGenerator::Options& mips) {
+    return CookedTexture::isUpToDate(filename, cookedPath(filename), MipGenerator::describe(mips));
+}
+
+bool TextureContainer::flipVertically(TextureImage& image) {
+    if (!image.compressed || image.internalFormat == GL_COMPRESSED_RGBA_BPTC_UNORM || image.internalFormat == GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM) {
+        return false;
+    }
+    for (const TextureLevel& level : image.levels) {
+        if (level.height > 4 && level.height % 4 != 0) {
+            return false;
+        }
+    }
+
+    size_t bytes = blockBytes(image.internalFormat);
+    bool twoBitAlpha = image.internalFormat == GL_COMPRESSED_RGBA_S3TC_DXT3_EXT || image.internalFormat == GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT;
+    bool colorBlocks = isS3tc(image.internalFormat);
+
+    // Reverse the first rows of a 2 bits indices table, one byte per row
+    auto flipColor = [](unsigned char* indices, int rows) {
+        std::reverse(indices, indices + rows);
+    };
+    // Reverse the first rows of a 3 bits indices table, 12 bits per row
+    auto flipAlpha = [](unsigned char* indices, int rows) {
+        uint64_t packed = 0, flipped = 0;
+        std::memcpy(&packed, indices, 6);
+        flipped = packed;
+        for (int y = 0; y < rows; y++) {
+            uint64_t row = (packed >> (12 * (rows - 1 - y))) & 0xFFF;
+            flipped = (flipped & ~(uint64_t(0xFFF) << (12 * y))) | row << (12 * y);
+        }
+        std::memcpy(indices, &flipped, 6);
+    };
+
+    for (const TextureLevel& level : image.levels) {
+        int blocksPerRow = (level.width + 3) / 4;
+        int blockRows = (level.height + 3) / 4;
+        int rows = std::min(level.height, 4);
+        size_t rowBytes = blocksPerRow * bytes;
+        unsigned char* pixels = image.pixels.data() + level.offset;
+
+        for (int by = 0; by < blockRows / 2; by++) {
+            std::swap_ranges(pixels + by * rowBytes, pixels + (by + 1) * rowBytes, pixels + (blockRows - 1 - by) * rowBytes);
+        }
+
+        for (size_t offset = 0; offset < level.size; offset += bytes) {
+            unsigned char* block = pixels + offset;
+            if (colorBlocks) {
+                if (bytes == 16) {
+                    if (twoBitAlpha) {
+                        // Explicit alpha, two bytes per row
+                        for (int y = 0; y < rows / 2; y++) {
+                            std::swap_ranges(block + 2 * y, block + 2 * y + 2, block + 2 * (rows - 1 - y));
+                        }
+                    } else {
+                        flipAlpha(block + 2, rows);
+                    }
+                    block += 8;
+                }
+                flipColor(block + 4, rows);
+            } else {
+                // BC4 and BC5 are made of one or two alpha like blocks
+                for (size_t channel = 0; channel < bytes; channel += 8) {
+                    flipAlpha(block + channel + 2, rows);
+                }
+            }
+        }
+    }
+    return true;
+}
+
+void TextureContainer::querySupport() {
+    if (s_queried) {
+        return;
+    }
+    s_queried = true;
+
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++) {
+        const char* name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+        if (std::strcmp(name, "GL_EXT_texture_compression_s3tc") == 0) {
+            s_s3tc = true;
+        } else if (std::strcmp(name, "GL_EXT_texture_sRGB") == 0 || std::strcmp(name, "GL_EXT_texture_compression_s3tc_srgb") == 0) {
+            s_s3tcSrgb = true;
+        }
+    }
+}
+
+bool TextureContainer::isSupported(GLenum internalFormat) {
+    if (!isS3tc(internalFormat)) {
+        return true;
+    }
+    return s_s3tc && (!isSrgb(internalFormat) || s_s3tcSrgb);
+}
+
+bool TextureContainer::decompress(TextureImage& image) {
+    if (!image.compressed || !isS3tc(image.internalFormat)) {
+        return false;
+    }
+
+    bool dxt1 = blockBytes(image.internalFormat) == 8;
+    bool dxt3 = image.internalFormat == GL_COMPRESSED_RGBA_S3TC_DXT3_EXT || image.internalFormat == GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT;
+    // The three colors mode only makes black texels transparent in the RGBA variants of BC1
+    bool punchThrough = image.internalFormat == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT || image.internalFormat == GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT;
+
+    std::vector<TextureLevel> levels;
+    std::vector<unsigned char> pixels;
+    for (const TextureLevel& level : image.levels) {
+        levels.push_back({ pixels.size(), static_cast<size_t>(level.width) * level.height * 4, level.width, level.height });
+        pixels.resize(pixels.size() + levels.back().size);
+        unsigned char* destination = pixels.data() + levels.back().offset;
+
+        const unsigned char* block = image.pixels.data() + level.offset;
+        for (int by = 0; by < level.height; by += 4) {
+            for (int bx = 0; bx < level.width; bx += 4) {
+                unsigned char texels[16][4];
+                if (dxt1) {
+                    decodeColorBlock(block, false, texels);
+                    if (!punchThrough) {
+                        for (auto& texel : texels) {
+                            texel[3] = 255;
+                        }
+                    }
+                } else {
+                    decodeColorBlock(block + 8, true, texels);
+                    if (dxt3) {
+                        for (int i = 0; i < 16; i++) {
+                            texels[i][3] = static_cast<unsigned char>(((block[i / 2] >> (4 * (i & 1))) & 15) * 17);
+                        }
+                    } else {
+                        decodeAlphaBlock(block, texels);
+                    }
+                }
+                block += dxt1 ? 8 : 16;
+
+                // Blocks on the right and bottom edges can hang over the level
+                for (int y = 0; y < 4 && by + y < level.height; y++) {
+                    for (int x = 0; x < 4 && bx + x < level.width; x++) {
+                        std::memcpy(destination + (static_cast<size_t>(by + y) * level.width + bx + x) * 4, texels[y * 4 + x], 4);
+                    }
+                }
+            }
+        }
+    }
+
+    image.internalFormat = isSrgb(image.internalFormat) ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+    image.format = GL_RGBA;
+    image.type = GL_UNSIGNED_BYTE;
+    image.channels = 4;
+    image.compressed = false;
+    image.levels = std::move(levels);
+    image.pixels = std::move(pixels);
+    return true;
+}
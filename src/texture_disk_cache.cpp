@@ -0,0 +1,161 @@
+#include "headers/texture_disk_cache.hpp"
+#include "headers/hash.hpp"
+#include "headers/logger.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+namespace {
+    // "AETX", Another-Engine TeXture
+    constexpr uint32_t MAGIC = 0x58544541;
+    // Bump when the decoded output changes, older entries then miss the cache
+    constexpr uint32_t VERSION = 2;
+    // Pixels start on a multiple of it, enough for the widest SIMD loads
+    constexpr size_t DATA_ALIGNMENT = 64;
+
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        int32_t width;
+        int32_t height;
+        int32_t channels;
+        uint32_t internalFormat;
+        uint32_t format;
+        uint32_t type;
+        uint32_t compressed;
+        uint32_t levelCount;
+        uint64_t dataOffset;
+        uint64_t dataSize;
+    };
+
+    struct Level {
+        uint64_t offset;
+        uint64_t size;
+        int32_t width;
+        int32_t height;
+    };
+}
+
+uint64_t TextureDiskCache::key(const unsigned char* source, size_t size, const std::string& options) {
+    uint64_t hash = fnv1a(std::string_view(reinterpret_cast<const char*>(source), size));
+    // The separator prevents the options from being confused with the last bytes of the file
+    hash = fnv1a(std::string_view("\0", 1), hash);
+    hash = fnv1a(options, hash);
+    return fnv1a(std::to_string(VERSION), hash);
+}
+
+std::string TextureDiskCache::path(uint64_t key) {
+    char name[17];
+    std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key));
+    return s_directory + name + ".bin";
+}
+
+bool TextureDiskCache::load(uint64_t key, TextureImage& image) {
+    if (!map(key, image)) {
+        s_misses++;
+        return false;
+    }
+    s_hits++;
+    return true;
+}
+
+bool TextureDiskCache::map(uint64_t key, TextureImage& image) {
+    auto mapping = std::make_shared<MappedFile>(path(key));
+    if (!mapping->isOpen()) {
+        return false;
+    }
+
+    Header header{};
+    bool valid = mapping->size() >= sizeof(Header);
+    if (valid) {
+        std::memcpy(&header, mapping->data(), sizeof(Header));
+        valid = header.magic == MAGIC && header.version == VERSION && header.levelCount > 0
+             && mapping->size() >= sizeof(Header) + header.levelCount * sizeof(Level)
+             && header.dataOffset <= mapping->size() && mapping->size() - header.dataOffset >= header.dataSize;
+    }
+
+    std::vector<TextureLevel> levels;
+    for (uint32_t i = 0; valid && i < header.levelCount; i++) {
+        Level level;
+        std::memcpy(&level, mapping->data() + sizeof(Header) + i * sizeof(Level), sizeof(Level));
+        valid = level.offset <= header.dataSize && header.dataSize - level.offset >= level.size;
+        levels.push_back({ static_cast<size_t>(level.offset), static_cast<size_t>(level.size), level.width, level.height });
+    }
+
+    if (!valid) {
+        // Truncated or outdated entry, it will be replaced once the image is decoded again
+        logger.warn("TEXTURE_CACHE::STALE_ENTRY " + path(key));
+        mapping.reset();
+        std::error_code error;
+        std::filesystem::remove(path(key), error);
+        return false;
+    }
+
+    image.width = header.width;
+    image.height = header.height;
+    image.channels = header.channels;
+    image.internalFormat = header.internalFormat;
+    image.format = header.format;
+    image.type = header.type;
+    image.compressed = header.compressed != 0;
+    image.levels = std::move(levels);
+    image.pixels.clear();
+    image.mappingOffset = static_cast<size_t>(header.dataOffset);
+    image.mappingSize = static_cast<size_t>(header.dataSize);
+    image.mapping = std::move(mapping);
+    return true;
+}
+
+void TextureDiskCache::store(uint64_t key, const TextureImage& image) {
+    Header header{};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.width = image.width;
+    header.height = image.height;
+    header.channels = image.channels;
+    header.internalFormat = image.internalFormat;
+    header.format = image.format;
+    header.type = image.type;
+    header.compressed = image.compressed;
+    header.levelCount = static_cast<uint32_t>(image.levels.size());
+    size_t tableEnd = sizeof(Header) + image.levels.size() * sizeof(Level);
+    header.dataOffset = (tableEnd + DATA_ALIGNMENT - 1) / DATA_ALIGNMENT * DATA_ALIGNMENT;
+    header.dataSize = image.byteSize();
+
+    std::error_code error;
+    std::filesystem::create_directories(s_directory, error);
+
+    // Unique per thread, two loaders may decode the same image
+    std::string temporary = path(key) + "." + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            logger.warn("TEXTURE_CACHE::CANNOT_WRITE " + path(key));
+            return;
+        }
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        for (const TextureLevel& level : image.levels) {
+            Level entry{ level.offset, level.size, level.width, level.height };
+            file.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+        }
+        const char padding[DATA_ALIGNMENT] = {};
+        file.write(padding, static_cast<std::streamsize>(header.dataOffset - tableEnd));
+        file.write(reinterpret_cast<const char*>(image.data()), static_cast<std::streamsize>(image.byteSize()));
+        if (!file) {
+            logger.warn("TEXTURE_CACHE::CANNOT_WRITE " + path(key));
+            file.close();
+            std::filesystem::remove(temporary, error);
+            return;
+        }
+    }
+
+    std::filesystem::rename(temporary, path(key), error);
+    if (error) {
+        logger.warn("TEXTURE_CACHE::CANNOT_WRITE " + path(key));
+        std::filesystem::remove(temporary, error);
+    }
+}
@@ -0,0 +1,52 @@
+#include "headers/thread_pool.hpp"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned int threads) {
+    threads = std::max(threads, 1u);
+    for (unsigned int i = 0; i < threads; i++) {
+        m_workers.emplace_back(&ThreadPool::run, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_condition.notify_all();
+
+    for (std::thread& worker : m_workers) {
+        worker.join();
+    }
+}
+
+ThreadPool& ThreadPool::loaders() {
+    // Keep a core for the main thread, which renders while the loaders work
+    static ThreadPool pool(std::max(std::thread::hardware_concurrency(), 2u) - 1);
+    return pool;
+}
+
+void ThreadPool::push(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_jobs.push_back(std::move(job));
+    }
+    m_condition.notify_one();
+}
+
+void ThreadPool::run() {
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this] { return m_stopping || !m_jobs.empty(); });
+            if (m_jobs.empty()) {
+                return;
+            }
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+        }
+        job();
+    }
+}
@@ -0,0 +1,76 @@
+#include "headers/uniform.hpp"
+
+void UniformTable::clear() {
+    m_slots.clear();
+    m_uniforms.clear();
+    m_used = 0;
+}
+
+bool UniformTable::insert(const UniformInfo &info) {
+    uint64_t hash = fnv1a(info.name);
+    if (find(hash) != -1) {
+        return false;
+    }
+
+    m_uniforms.push_back(info);
+    place(hash, static_cast<int>(m_uniforms.size() - 1));
+    return true;
+}
+
+bool UniformTable::alias(const std::string &name, int index) {
+    uint64_t hash = fnv1a(name);
+    if (find(hash) != -1) {
+        return false;
+    }
+
+    place(hash, index);
+    return true;
+}
+
+int UniformTable::find(uint64_t hash) const {
+    if (m_slots.empty()) {
+        return -1;
+    }
+
+    size_t mask = m_slots.size() - 1;
+    size_t i = hash & mask;
+    while (m_slots[i].index != -1) {
+        if (m_slots[i].hash == hash) {
+            return m_slots[i].index;
+        }
+        i = (i + 1) & mask;
+    }
+    return -1;
+}
+
+void UniformTable::place(uint64_t hash, int index) {
+    // Keep the load factor under 50% so probing sequences stay short
+    if ((m_used + 1) * 2 > m_slots.size()) {
+        grow();
+    }
+
+    size_t mask = m_slots.size() - 1;
+    size_t i = hash & mask;
+    while (m_slots[i].index != -1) {
+        i = (i + 1) & mask;
+    }
+    m_slots[i] = { hash, index };
+    m_used++;
+}
+
+void UniformTable::grow() {
+    std::vector<Slot> old = std::move(m_slots);
+    m_slots.assign(old.empty() ? 16 : old.size() * 2, Slot{});
+
+    size_t mask = m_slots.size() - 1;
+    for (const Slot &slot : old) {
+        if (slot.index == -1) {
+            continue;
+        }
+        size_t i = slot.hash & mask;
+        while (m_slots[i].index != -1) {
+            i = (i + 1) & mask;
+        }
+        m_slots[i] = slot;
+    }
+}
@@ -0,0 +1,89 @@
+#include "headers/vertex_array.hpp"
+#include "headers/hash.hpp"
+#include "headers/logger.hpp"
+
+namespace {
+    std::string_view bytes(const GLuint& value) {
+        return std::string_view(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    /**
+     * @brief Shader input types fed with glVertexAttribIPointer
+     */
+    bool isIntegerInput(GLenum type) {
+        switch (type) {
+            case GL_INT: case GL_INT_VEC2: case GL_INT_VEC3: case GL_INT_VEC4:
+            case GL_UNSIGNED_INT: case GL_UNSIGNED_INT_VEC2: case GL_UNSIGNED_INT_VEC3: case GL_UNSIGNED_INT_VEC4:
+                return true;
+            default:
+                return false;
+        }
+    }
+}
+
+GLuint VertexArrayCache::get(const VertexFormat& format, GLuint vertexBuffer, GLuint indexBuffer, const Shader& shader) {
+    uint64_t key = fnv1a(bytes(vertexBuffer), format.hash() ^ shader.getInterfaceHash());
+    key = fnv1a(bytes(indexBuffer), key);
+
+    auto it = s_cache.find(key);
+    if (it != s_cache.end()) {
+        return it->second.vao;
+    }
+
+    // Failures are cached too so a mismatch is reported once instead of every frame
+    GLuint vao = build(format, vertexBuffer, indexBuffer, shader);
+    s_cache.emplace(key, Entry{ vao, vertexBuffer, indexBuffer });
+    return vao;
+}
+
+void VertexArrayCache::release(GLuint buffer) {
+    for (auto it = s_cache.begin(); it != s_cache.end();) {
+        if (it->second.vertexBuffer == buffer || it->second.indexBuffer == buffer) {
+            glDeleteVertexArrays(1, &it->second.vao);
+            it = s_cache.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+GLuint VertexArrayCache::build(const VertexFormat& format, GLuint vertexBuffer, GLuint indexBuffer, const Shader& shader) {
+    // Check everything before creating anything
+    for (const AttributeInfo& input : shader.getAttributes()) {
+        VertexSemantic semantic;
+        if (!semanticFromName(input.name, semantic)) {
+            logger.error("VERTEX_ARRAY::UNKNOWN_SEMANTIC input [" + input.name + "] of " + shader.getVertexPath());
+            return 0;
+        }
+        if (format.find(semantic) == nullptr) {
+            logger.error("VERTEX_ARRAY::MISSING_ATTRIBUTE " + std::string(semanticName(semantic)) + " needed by ["
+                         + input.name + "] of " + shader.getVertexPath());
+            return 0;
+        }
+    }
+
+    GLuint vao;
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    if (indexBuffer != 0) {
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    }
+
+    for (const AttributeInfo& input : shader.getAttributes()) {
+        VertexSemantic semantic;
+        semanticFromName(input.name, semantic);
+        const VertexAttribute* attribute = format.find(semantic);
+
+        const void* offset = reinterpret_cast<const void*>(static_cast<uintptr_t>(attribute->offset));
+        if (isIntegerInput(input.type)) {
+            glVertexAttribIPointer(input.location, attribute->components, attribute->type, format.stride, offset);
+        } else {
+            glVertexAttribPointer(input.location, attribute->components, attribute->type, attribute->normalized, format.stride, offset);
+        }
+        glEnableVertexAttribArray(input.location);
+    }
+
+    glBindVertexArray(0);
+    return vao;
+}
@@ -0,0 +1,68 @@
+#include "headers/vertex_format.hpp"
+#include "headers/hash.hpp"
+
+#include <string_view>
+
+namespace {
+    struct SemanticName {
+        const char* name;
+        VertexSemantic semantic;
+    };
+
+    // Names used by the inputs of our shaders
+    constexpr SemanticName SEMANTIC_NAMES[] = {
+        { "aPos", VertexSemantic::POSITION },
+        { "aPosition", VertexSemantic::POSITION },
+        { "aNormal", VertexSemantic::NORMAL },
+        { "aTexCoord", VertexSemantic::TEXCOORD },
+        { "aTexCoords", VertexSemantic::TEXCOORD },
+        { "aTangent", VertexSemantic::TANGENT },
+        { "aColor", VertexSemantic::COLOR },
+    };
+}
+
+bool semanticFromName(const std::string& name, VertexSemantic& semantic) {
+    for (const SemanticName& entry : SEMANTIC_NAMES) {
+        if (name == entry.name) {
+            semantic = entry.semantic;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* semanticName(VertexSemantic semantic) {
+    switch (semantic) {
+        case VertexSemantic::POSITION: return "POSITION";
+        case VertexSemantic::NORMAL: return "NORMAL";
+        case VertexSemantic::TEXCOORD: return "TEXCOORD";
+        case VertexSemantic::TANGENT: return "TANGENT";
+        case VertexSemantic::COLOR: return "COLOR";
+    }
+    return "UNKNOWN";
+}
+
+const VertexAttribute* VertexFormat::find(VertexSemantic semantic) const {
+    for (const VertexAttribute& attribute : attributes) {
+        if (attribute.semantic == semantic) {
+            return &attribute;
+        }
+    }
+    return nullptr;
+}
+
+uint64_t VertexFormat::hash() const {
+    auto bytes = [](const auto& value) {
+        return std::string_view(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+
+    uint64_t hash = fnv1a(bytes(stride));
+    for (const VertexAttribute& attribute : attributes) {
+        hash = fnv1a(bytes(attribute.semantic), hash);
+        hash = fnv1a(bytes(attribute.components), hash);
+        hash = fnv1a(bytes(attribute.type), hash);
+        hash = fnv1a(bytes(attribute.normalized), hash);
+        hash = fnv1a(bytes(attribute.offset), hash);
+    }
+    return hash;
+}
@@ -0,0 +1,222 @@
+#include "headers/vertex_quantization.hpp"
+#include "headers/half_float.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+namespace {
+    /**
+     * @brief Both compact layouts, only the encoding of the texture coordinates differs
+     */
+    struct CompactVertex {
+        // The fourth component pads the normal to 4 bytes
+        uint16_t position[4];
+        int16_t normal[2];
+        uint16_t texCoords[2];
+    };
+
+    static_assert(sizeof(CompactVertex) == 16, "Compact vertices are 16 bytes");
+
+    constexpr float UNORM16_MAX = 65535.0f;
+    constexpr float SNORM16_MAX = 32767.0f;
+    // Measured error of 16 bits octahedral normals is around 0.005 degrees, with margin
+    constexpr float OCTAHEDRAL_ERROR = 0.01f;
+
+    uint16_t toUnorm16(float value, float offset, float scale) {
+        float normalized = scale > 0.0f ? (value - offset) / scale : 0.0f;
+        return static_cast<uint16_t>(std::lround(std::clamp(normalized, 0.0f, 1.0f) * UNORM16_MAX));
+    }
+
+    float fromUnorm16(uint16_t value, float offset, float scale) {
+        return offset + scale * (static_cast<float>(value) / UNORM16_MAX);
+    }
+
+    int16_t toSnorm16(float value) {
+        return static_cast<int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * SNORM16_MAX));
+    }
+
+    float fromSnorm16(int16_t value) {
+        return std::max(static_cast<float>(value) / SNORM16_MAX, -1.0f);
+    }
+
+    /**
+     * @brief Slack for the float arithmetic of the decode, on top of the rounding of the quantization
+     */
+    float decodeSlack(float offset, float scale) {
+        return 4.0f * FLT_EPSILON * (std::abs(offset) + std::abs(scale));
+    }
+}
+
+glm::mat4 VertexQuantization::Decode::positionTransform() const {
+    return glm::scale(glm::translate(glm::mat4(1.0f), positionOffset), positionScale);
+}
+
+size_t VertexQuantization::stride(VertexLayout layout) {
+    return layout == VertexLayout::FLOAT ? sizeof(MeshVertex) : sizeof(CompactVertex);
+}
+
+VertexFormat VertexQuantization::format(VertexLayout layout) {
+    if (layout == VertexLayout::FLOAT) {
+        return MeshData::vertexFormat();
+    }
+
+    VertexFormat format;
+    format.stride = sizeof(CompactVertex);
+    format.attributes = {
+        { VertexSemantic::POSITION, 3, GL_UNSIGNED_SHORT, GL_TRUE, offsetof(CompactVertex, position) },
+        { VertexSemantic::NORMAL, 2, GL_SHORT, GL_TRUE, offsetof(CompactVertex, normal) },
+        layout == VertexLayout::COMPACT_HALF_UV ? VertexAttribute{ VertexSemantic::TEXCOORD, 2, GL_HALF_FLOAT, GL_FALSE, offsetof(CompactVertex, texCoords) }
+                                                : VertexAttribute{ VertexSemantic::TEXCOORD, 2, GL_UNSIGNED_SHORT, GL_TRUE, offsetof(CompactVertex, texCoords) },
+    };
+    return format;
+}
+
+VertexQuantization::Decode VertexQuantization::computeDecode(const std::vector<MeshVertex>& vertices, VertexLayout layout) {
+    Decode decode;
+    if (layout == VertexLayout::FLOAT || vertices.empty()) {
+        return decode;
+    }
+
+    MeshBounds bounds;
+    glm::vec2 texCoordMin(FLT_MAX), texCoordMax(-FLT_MAX);
+    for (const MeshVertex& vertex : vertices) {
+        bounds.extend(vertex.position);
+        texCoordMin = glm::min(texCoordMin, vertex.texCoords);
+        texCoordMax = glm::max(texCoordMax, vertex.texCoords);
+    }
+    decode.positionOffset = bounds.min;
+    decode.positionScale = bounds.max - bounds.min;
+    // Half floats are stored as they are
+    if (layout == VertexLayout::COMPACT_UNORM_UV) {
+        decode.texCoordOffset = texCoordMin;
+        decode.texCoordScale = texCoordMax - texCoordMin;
+    }
+    return decode;
+}
+
+std::vector<uint8_t> VertexQuantization::encode(const std::vector<MeshVertex>& vertices, VertexLayout layout, const Decode& decode) {
+    std::vector<uint8_t> encoded(vertices.size() * stride(layout));
+    if (layout == VertexLayout::FLOAT) {
+        std::memcpy(encoded.data(), vertices.data(), encoded.size());
+        return encoded;
+    }
+
+    CompactVertex* compact = reinterpret_cast<CompactVertex*>(encoded.data());
+    for (size_t i = 0; i < vertices.size(); i++) {
+        const MeshVertex& vertex = vertices[i];
+        for (int axis = 0; axis < 3; axis++) {
+            compact[i].position[axis] = toUnorm16(vertex.position[axis], decode.positionOffset[axis], decode.positionScale[axis]);
+        }
+        compact[i].position[3] = 0;
+
+        glm::vec2 normal = octahedralEncode(vertex.normal);
+        compact[i].normal[0] = toSnorm16(normal.x);
+        compact[i].normal[1] = toSnorm16(normal.y);
+
+        for (int axis = 0; axis < 2; axis++) {
+            compact[i].texCoords[axis] = layout == VertexLayout::COMPACT_HALF_UV
+                                             ? HalfFloat::fromFloat(vertex.texCoords[axis])
+                                             : toUnorm16(vertex.texCoords[axis], decode.texCoordOffset[axis], decode.texCoordScale[axis]);
+        }
+    }
+    return encoded;
+}
+
+MeshVertex VertexQuantization::decode(const uint8_t* vertex, VertexLayout layout, const Decode& decode) {
+    MeshVertex decoded;
+    if (layout == VertexLayout::FLOAT) {
+        std::memcpy(&decoded, vertex, sizeof(MeshVertex));
+        return decoded;
+    }
+
+    CompactVertex compact;
+    std::memcpy(&compact, vertex, sizeof(CompactVertex));
+    for (int axis = 0; axis < 3; axis++) {
+        decoded.position[axis] = fromUnorm16(compact.position[axis], decode.positionOffset[axis], decode.positionScale[axis]);
+    }
+    decoded.normal = octahedralDecode(glm::vec2(fromSnorm16(compact.normal[0]), fromSnorm16(compact.normal[1])));
+    for (int axis = 0; axis < 2; axis++) {
+        decoded.texCoords[axis] = layout == VertexLayout::COMPACT_HALF_UV
+                                      ? HalfFloat::toFloat(compact.texCoords[axis])
+                                      : fromUnorm16(compact.texCoords[axis], decode.texCoordOffset[axis], decode.texCoordScale[axis]);
+    }
+    return decoded;
+}
+
+VertexQuantization::Error VertexQuantization::measure(const std::vector<MeshVertex>& vertices, const std::vector<uint8_t>& encoded, VertexLayout layout,
+                                                      const Decode& decode) {
+    Error error;
+    size_t vertexStride = stride(layout);
+    for (size_t i = 0; i < vertices.size() && (i + 1) * vertexStride <= encoded.size(); i++) {
+        const MeshVertex& reference = vertices[i];
+        MeshVertex decoded = VertexQuantization::decode(encoded.data() + i * vertexStride, layout, decode);
+
+        glm::vec3 position = glm::abs(decoded.position - reference.position);
+        error.position = std::max({ error.position, position.x, position.y, position.z });
+        glm::vec2 texCoords = glm::abs(decoded.texCoords - reference.texCoords);
+        error.texCoord = std::max({ error.texCoord, texCoords.x, texCoords.y });
+
+        // Meshes without normals have null ones, they decode to an arbitrary direction
+        double length = glm::length(glm::dvec3(reference.normal));
+        if (length > 1e-6) {
+            // The chord is precise for the tiny angles acos would lose
+            double chord = glm::length(glm::dvec3(reference.normal) / length - glm::dvec3(glm::normalize(decoded.normal)));
+            error.normal = std::max(error.normal, static_cast<float>(glm::degrees(2.0 * std::asin(std::min(chord * 0.5, 1.0)))));
+        }
+    }
+    return error;
+}
+
+VertexQuantization::Error VertexQuantization::bounds(VertexLayout layout, const Decode& decode, const std::vector<MeshVertex>& vertices) {
+    Error error;
+    if (layout == VertexLayout::FLOAT) {
+        return error;
+    }
+
+    for (int axis = 0; axis < 3; axis++) {
+        float step = decode.positionScale[axis] / UNORM16_MAX;
+        error.position = std::max(error.position, step * 0.5f + decodeSlack(decode.positionOffset[axis], decode.positionScale[axis]));
+    }
+    error.normal = OCTAHEDRAL_ERROR;
+
+    if (layout == VertexLayout::COMPACT_UNORM_UV) {
+        for (int axis = 0; axis < 2; axis++) {
+            float step = decode.texCoordScale[axis] / UNORM16_MAX;
+            error.texCoord = std::max(error.texCoord, step * 0.5f + decodeSlack(decode.texCoordOffset[axis], decode.texCoordScale[axis]));
+        }
+    } else {
+        float largest = 0.0f;
+        for (const MeshVertex& vertex : vertices) {
+            largest = std::max({ largest, std::abs(vertex.texCoords.x), std::abs(vertex.texCoords.y) });
+        }
+        // Half of the spacing of halves at the largest coordinate, the spacing of subnormals below 2^-14
+        int exponent = largest >= std::ldexp(1.0f, -14) ? std::ilogb(largest) : -14;
+        error.texCoord = largest > 65504.0f ? INFINITY : std::ldexp(1.0f, exponent - 11);
+    }
+    return error;
+}
+
+glm::vec2 VertexQuantization::octahedralEncode(const glm::vec3& normal) {
+    float sum = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+    if (sum <= 0.0f) {
+        return glm::vec2(0.0f);
+    }
+    glm::vec2 encoded = glm::vec2(normal.x, normal.y) / sum;
+    // The lower half is folded over the diagonals
+    if (normal.z < 0.0f) {
+        encoded = (1.0f - glm::abs(glm::vec2(encoded.y, encoded.x))) * glm::vec2(encoded.x >= 0.0f ? 1.0f : -1.0f, encoded.y >= 0.0f ? 1.0f : -1.0f);
+    }
+    return encoded;
+}
+
+glm::vec3 VertexQuantization::octahedralDecode(const glm::vec2& encoded) {
+    glm::vec3 normal(encoded.x, encoded.y, 1.0f - std::abs(encoded.x) - std::abs(encoded.y));
+    float fold = std::max(-normal.z, 0.0f);
+    normal.x += normal.x >= 0.0f ? -fold : fold;
+    normal.y += normal.y >= 0.0f ? -fold : fold;
+    return glm::normalize(normal);
+}
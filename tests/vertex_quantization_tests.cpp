@@ -0,0 +1,213 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+
+#include "headers/vertex_quantization.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <random>
+#include <vector>
+
+namespace {
+    const VertexLayout COMPACT_LAYOUTS[] = { VertexLayout::COMPACT_HALF_UV, VertexLayout::COMPACT_UNORM_UV };
+
+    const char* layoutName(VertexLayout layout) {
+        return layout == VertexLayout::COMPACT_HALF_UV ? "half" : "unorm";
+    }
+
+    glm::vec3 randomNormal(std::mt19937& random) {
+        std::normal_distribution<float> gaussian;
+        glm::vec3 normal;
+        do {
+            normal = glm::vec3(gaussian(random), gaussian(random), gaussian(random));
+        } while (glm::length(normal) < 1e-3f);
+        return glm::normalize(normal);
+    }
+
+    std::vector<MeshVertex> randomVertices(std::mt19937& random, size_t count, glm::vec3 center, float extent, glm::vec2 uvMin, glm::vec2 uvMax) {
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        std::vector<MeshVertex> vertices(count);
+        for (MeshVertex& vertex : vertices) {
+            vertex.position = center + extent * glm::vec3(unit(random), unit(random), unit(random)) - extent * 0.5f;
+            vertex.normal = randomNormal(random);
+            vertex.texCoords = glm::mix(uvMin, uvMax, glm::vec2(unit(random), unit(random)));
+        }
+        return vertices;
+    }
+
+    /**
+     * @brief Encode the vertices in a layout and compare every decoded vertex with its float version
+     */
+    void checkWithinBounds(const std::vector<MeshVertex>& vertices, VertexLayout layout) {
+        CAPTURE(layoutName(layout));
+        VertexQuantization::Decode decode = VertexQuantization::computeDecode(vertices, layout);
+        std::vector<uint8_t> encoded = VertexQuantization::encode(vertices, layout, decode);
+        REQUIRE(encoded.size() == vertices.size() * VertexQuantization::stride(layout));
+        VertexQuantization::Error bounds = VertexQuantization::bounds(layout, decode, vertices);
+
+        for (size_t i = 0; i < vertices.size(); i++) {
+            const MeshVertex& reference = vertices[i];
+            MeshVertex decoded = VertexQuantization::decode(encoded.data() + i * VertexQuantization::stride(layout), layout, decode);
+            CAPTURE(i);
+
+            for (int axis = 0; axis < 3; axis++) {
+                CHECK(std::abs(decoded.position[axis] - reference.position[axis]) <= bounds.position);
+            }
+            for (int axis = 0; axis < 2; axis++) {
+                CHECK(std::abs(decoded.texCoords[axis] - reference.texCoords[axis]) <= bounds.texCoord);
+            }
+
+            // Computed in double, acos of the float dot product can't resolve hundredths of a degree
+            glm::dvec3 expected = glm::normalize(glm::dvec3(reference.normal));
+            glm::dvec3 actual = glm::normalize(glm::dvec3(decoded.normal));
+            double angle = glm::degrees(2.0 * std::asin(std::min(glm::length(expected - actual) * 0.5, 1.0)));
+            CHECK(angle <= bounds.normal);
+        }
+
+        VertexQuantization::Error error = VertexQuantization::measure(vertices, encoded, layout, decode);
+        CHECK(error.position <= bounds.position);
+        CHECK(error.normal <= bounds.normal);
+        CHECK(error.texCoord <= bounds.texCoord);
+    }
+}
+
+TEST_CASE("Compact layouts are 16 bytes") {
+    CHECK(VertexQuantization::stride(VertexLayout::FLOAT) == sizeof(MeshVertex));
+    for (VertexLayout layout : COMPACT_LAYOUTS) {
+        CHECK(VertexQuantization::stride(layout) == 16);
+    }
+}
+
+TEST_CASE("Random vertices decode within the bounds") {
+    std::mt19937 random(42);
+    std::vector<MeshVertex> vertices = randomVertices(random, 10000, glm::vec3(0.0f), 20.0f, glm::vec2(0.0f), glm::vec2(1.0f));
+    for (VertexLayout layout : COMPACT_LAYOUTS) {
+        checkWithinBounds(vertices, layout);
+    }
+}
+
+TEST_CASE("Flat axes decode exactly") {
+    std::mt19937 random(1);
+    std::vector<MeshVertex> vertices = randomVertices(random, 1000, glm::vec3(0.0f), 4.0f, glm::vec2(0.0f), glm::vec2(1.0f));
+    for (MeshVertex& vertex : vertices) {
+        vertex.position.y = 3.5f;
+        vertex.texCoords.x = 0.25f;
+    }
+
+    for (VertexLayout layout : COMPACT_LAYOUTS) {
+        checkWithinBounds(vertices, layout);
+
+        VertexQuantization::Decode decode = VertexQuantization::computeDecode(vertices, layout);
+        std::vector<uint8_t> encoded = VertexQuantization::encode(vertices, layout, decode);
+        CHECK(decode.positionScale.y == 0.0f);
+        for (size_t i = 0; i < vertices.size(); i++) {
+            MeshVertex decoded = VertexQuantization::decode(encoded.data() + i * VertexQuantization::stride(layout), layout, decode);
+            CHECK(decoded.position.y == 3.5f);
+            CHECK(decoded.texCoords.x == 0.25f);
+        }
+    }
+}
+
+TEST_CASE("Large offsets decode within the bounds") {
+    std::mt19937 random(2);
+    SUBCASE("Small mesh far from the origin") {
+        std::vector<MeshVertex> vertices = randomVertices(random, 1000, glm::vec3(1e5f, -2e5f, 5e4f), 1.0f, glm::vec2(0.0f), glm::vec2(1.0f));
+        for (VertexLayout layout : COMPACT_LAYOUTS) {
+            checkWithinBounds(vertices, layout);
+        }
+    }
+    SUBCASE("Large mesh") {
+        std::vector<MeshVertex> vertices = randomVertices(random, 1000, glm::vec3(0.0f), 1e6f, glm::vec2(0.0f), glm::vec2(1.0f));
+        for (VertexLayout layout : COMPACT_LAYOUTS) {
+            checkWithinBounds(vertices, layout);
+        }
+    }
+}
+
+TEST_CASE("Texture coordinates past 1 decode within the bounds") {
+    std::mt19937 random(3);
+    SUBCASE("Tiled") {
+        std::vector<MeshVertex> vertices = randomVertices(random, 1000, glm::vec3(0.0f), 1.0f, glm::vec2(-3.0f), glm::vec2(7.0f));
+        for (VertexLayout layout : COMPACT_LAYOUTS) {
+            checkWithinBounds(vertices, layout);
+        }
+    }
+    SUBCASE("Far from the origin") {
+        std::vector<MeshVertex> vertices = randomVertices(random, 1000, glm::vec3(0.0f), 1.0f, glm::vec2(1000.0f), glm::vec2(4000.0f));
+        for (VertexLayout layout : COMPACT_LAYOUTS) {
+            checkWithinBounds(vertices, layout);
+        }
+    }
+    SUBCASE("Exactly on the half float steps") {
+        std::vector<MeshVertex> vertices = randomVertices(random, 4, glm::vec3(0.0f), 1.0f, glm::vec2(0.0f), glm::vec2(1.0f));
+        vertices[0].texCoords = glm::vec2(1.0f, 2.0f);
+        vertices[1].texCoords = glm::vec2(-1.0f, 65504.0f);
+        vertices[2].texCoords = glm::vec2(0.5f, 1.0f + 1.0f / 1024.0f);
+        vertices[3].texCoords = glm::vec2(0.0f, 16.0f);
+        for (VertexLayout layout : COMPACT_LAYOUTS) {
+            checkWithinBounds(vertices, layout);
+        }
+    }
+}
+
+TEST_CASE("Subnormal texture coordinates decode within the bounds") {
+    std::mt19937 random(4);
+    // Below 2^-14 halves are subnormal, spaced by 2^-24
+    std::vector<MeshVertex> vertices = randomVertices(random, 1000, glm::vec3(0.0f), 1.0f, glm::vec2(0.0f), glm::vec2(std::ldexp(1.0f, -15)));
+    vertices[0].texCoords = glm::vec2(std::ldexp(1.0f, -24), std::ldexp(3.0f, -26));
+    vertices[1].texCoords = glm::vec2(-std::ldexp(1.0f, -20), 1e-7f);
+    for (VertexLayout layout : COMPACT_LAYOUTS) {
+        checkWithinBounds(vertices, layout);
+    }
+
+    VertexQuantization::Decode decode = VertexQuantization::computeDecode(vertices, VertexLayout::COMPACT_HALF_UV);
+    CHECK(VertexQuantization::bounds(VertexLayout::COMPACT_HALF_UV, decode, vertices).texCoord == std::ldexp(1.0f, -25));
+}
+
+TEST_CASE("Axis aligned and negative z normals decode within the bounds") {
+    std::mt19937 random(5);
+    std::vector<MeshVertex> vertices = randomVertices(random, 1000, glm::vec3(0.0f), 2.0f, glm::vec2(0.0f), glm::vec2(1.0f));
+    const glm::vec3 axes[] = { { 1.0f, 0.0f, 0.0f }, { -1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f },
+                               { 0.0f, -1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, -1.0f } };
+    for (size_t i = 0; i < vertices.size(); i++) {
+        if (i < std::size(axes)) {
+            vertices[i].normal = axes[i];
+        } else {
+            // The lower hemisphere is the folded half of the octahedron, down to normals barely below the equator
+            glm::vec3 normal = randomNormal(random);
+            normal.z = -std::abs(normal.z) * (i % 2 == 0 ? 1.0f : 1e-3f);
+            vertices[i].normal = glm::normalize(normal);
+        }
+    }
+    for (VertexLayout layout : COMPACT_LAYOUTS) {
+        checkWithinBounds(vertices, layout);
+    }
+
+    for (const glm::vec3& axis : axes) {
+        CAPTURE(axis.x);
+        CAPTURE(axis.y);
+        CAPTURE(axis.z);
+        glm::vec3 decoded = VertexQuantization::octahedralDecode(VertexQuantization::octahedralEncode(axis));
+        CHECK(decoded.x == doctest::Approx(axis.x));
+        CHECK(decoded.y == doctest::Approx(axis.y));
+        CHECK(decoded.z == doctest::Approx(axis.z));
+    }
+}
+
+TEST_CASE("Octahedral encoding round-trips") {
+    std::mt19937 random(6);
+    for (int i = 0; i < 20000; i++) {
+        glm::vec3 normal = randomNormal(random);
+        glm::vec2 encoded = VertexQuantization::octahedralEncode(normal);
+        CHECK(std::abs(encoded.x) <= 1.0f);
+        CHECK(std::abs(encoded.y) <= 1.0f);
+        // The upper hemisphere stays inside the diamond, the lower one is folded outside of it
+        if (normal.z > 0.0f) {
+            CHECK(std::abs(encoded.x) + std::abs(encoded.y) <= 1.0f + 1e-6f);
+        }
+
+        glm::vec3 decoded = VertexQuantization::octahedralDecode(encoded);
+        CHECK(glm::length(decoded - normal) < 1e-5f);
+    }
+}
@@ -0,0 +1,236 @@
+#include "bc_encoder.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define BC_ENCODER_SSE2
+#endif
+
+namespace {
+    /**
+     * @brief Per channel minimum and maximum of the 16 texels of a block
+     */
+    void boundingBox(const uint8_t block[64], uint8_t min[4], uint8_t max[4]) {
+#if defined(__AVX2__) || defined(BC_ENCODER_SSE2)
+        __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block));
+        __m128i hi = lo;
+        for (int i = 1; i < 4; i++) {
+            __m128i texels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * i));
+            lo = _mm_min_epu8(lo, texels);
+            hi = _mm_max_epu8(hi, texels);
+        }
+        // Fold the four texels of each register down to one
+        lo = _mm_min_epu8(lo, _mm_shuffle_epi32(lo, _MM_SHUFFLE(1, 0, 3, 2)));
+        lo = _mm_min_epu8(lo, _mm_shuffle_epi32(lo, _MM_SHUFFLE(2, 3, 0, 1)));
+        hi = _mm_max_epu8(hi, _mm_shuffle_epi32(hi, _MM_SHUFFLE(1, 0, 3, 2)));
+        hi = _mm_max_epu8(hi, _mm_shuffle_epi32(hi, _MM_SHUFFLE(2, 3, 0, 1)));
+        int packedMin = _mm_cvtsi128_si32(lo);
+        int packedMax = _mm_cvtsi128_si32(hi);
+        std::memcpy(min, &packedMin, 4);
+        std::memcpy(max, &packedMax, 4);
+#else
+        for (int c = 0; c < 4; c++) {
+            min[c] = max[c] = block[c];
+        }
+        for (int i = 1; i < 16; i++) {
+            for (int c = 0; c < 4; c++) {
+                min[c] = std::min(min[c], block[4 * i + c]);
+                max[c] = std::max(max[c], block[4 * i + c]);
+            }
+        }
+#endif
+    }
+
+    /**
+     * @brief Project every texel on the axis going from base to base + direction
+     *
+     * @param steps The number of intervals on the axis, 3 for colors and 7 for channels
+     * @param positions The position of each texel, rounded to the closest step
+     */
+    void project(const uint8_t block[64], const int16_t base[4], const int16_t direction[4], int steps, int positions[16]) {
+        int length = direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2] + direction[3] * direction[3];
+        if (length == 0) {
+            std::fill(positions, positions + 16, 0);
+            return;
+        }
+        float scale = static_cast<float>(steps) / static_cast<float>(length);
+
+#if defined(__AVX2__)
+        const __m256i baseVector = _mm256_setr_epi16(base[0], base[1], base[2], base[3], base[0], base[1], base[2], base[3],
+                                                     base[0], base[1], base[2], base[3], base[0], base[1], base[2], base[3]);
+        const __m256i directionVector = _mm256_setr_epi16(direction[0], direction[1], direction[2], direction[3],
+                                                          direction[0], direction[1], direction[2], direction[3],
+                                                          direction[0], direction[1], direction[2], direction[3],
+                                                          direction[0], direction[1], direction[2], direction[3]);
+        // hadd leaves the texels as 0 1 4 5 | 2 3 6 7, put them back in order
+        const __m256i order = _mm256_setr_epi32(0, 1, 4, 5, 2, 3, 6, 7);
+        for (int i = 0; i < 16; i += 8) {
+            __m256i first = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 4 * i)));
+            __m256i second = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 4 * i + 16)));
+            first = _mm256_madd_epi16(_mm256_sub_epi16(first, baseVector), directionVector);
+            second = _mm256_madd_epi16(_mm256_sub_epi16(second, baseVector), directionVector);
+            __m256i dots = _mm256_permutevar8x32_epi32(_mm256_hadd_epi32(first, second), order);
+
+            __m256 position = _mm256_add_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(dots), _mm256_set1_ps(scale)), _mm256_set1_ps(0.5f));
+            position = _mm256_min_ps(_mm256_max_ps(position, _mm256_setzero_ps()), _mm256_set1_ps(static_cast<float>(steps)));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(positions + i), _mm256_cvttps_epi32(position));
+        }
+#elif defined(BC_ENCODER_SSE2)
+        const __m128i baseVector = _mm_setr_epi16(base[0], base[1], base[2], base[3], base[0], base[1], base[2], base[3]);
+        const __m128i directionVector = _mm_setr_epi16(direction[0], direction[1], direction[2], direction[3],
+                                                       direction[0], direction[1], direction[2], direction[3]);
+        const __m128i zero = _mm_setzero_si128();
+        for (int i = 0; i < 16; i += 4) {
+            __m128i texels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 4 * i));
+            __m128i first = _mm_madd_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(texels, zero), baseVector), directionVector);
+            __m128i second = _mm_madd_epi16(_mm_sub_epi16(_mm_unpackhi_epi8(texels, zero), baseVector), directionVector);
+            // Each texel is split in two partial sums, lanes 0 and 2 hold the dot products once added
+            first = _mm_add_epi32(first, _mm_shuffle_epi32(first, _MM_SHUFFLE(2, 3, 0, 1)));
+            second = _mm_add_epi32(second, _mm_shuffle_epi32(second, _MM_SHUFFLE(2, 3, 0, 1)));
+            __m128 dots = _mm_shuffle_ps(_mm_cvtepi32_ps(first), _mm_cvtepi32_ps(second), _MM_SHUFFLE(2, 0, 2, 0));
+
+            __m128 position = _mm_add_ps(_mm_mul_ps(dots, _mm_set1_ps(scale)), _mm_set1_ps(0.5f));
+            position = _mm_min_ps(_mm_max_ps(position, _mm_setzero_ps()), _mm_set1_ps(static_cast<float>(steps)));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(positions + i), _mm_cvttps_epi32(position));
+        }
+#else
+        for (int i = 0; i < 16; i++) {
+            int dot = 0;
+            for (int c = 0; c < 4; c++) {
+                dot += (block[4 * i + c] - base[c]) * direction[c];
+            }
+            positions[i] = static_cast<int>(std::clamp(dot * scale + 0.5f, 0.0f, static_cast<float>(steps)));
+        }
+#endif
+    }
+
+    uint16_t to565(const uint8_t color[4]) {
+        return static_cast<uint16_t>((color[0] * 31 + 127) / 255 << 11 | (color[1] * 63 + 127) / 255 << 5 | (color[2] * 31 + 127) / 255);
+    }
+
+    void from565(uint16_t color, int16_t rgb[4]) {
+        rgb[0] = static_cast<int16_t>(((color >> 11) & 31) * 255 / 31);
+        rgb[1] = static_cast<int16_t>(((color >> 5) & 63) * 255 / 63);
+        rgb[2] = static_cast<int16_t>((color & 31) * 255 / 31);
+        rgb[3] = 0;
+    }
+
+    /**
+     * @brief Move both ends of the box inwards by a sixteenth of its size,
+     * the extremes are usually outliers and the palette gets denser where texels are
+     */
+    void inset(uint8_t &min, uint8_t &max, int shift) {
+        int offset = (max - min) >> shift;
+        min = static_cast<uint8_t>(std::min(min + offset, 255));
+        max = static_cast<uint8_t>(std::max(max - offset, 0));
+    }
+}
+
+size_t BcEncoder::blockBytes(Format format) {
+    return format == Format::BC1 ? 8 : 16;
+}
+
+size_t BcEncoder::levelSize(Format format, int width, int height) {
+    return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * blockBytes(format);
+}
+
+void BcEncoder::encode(Format format, const uint8_t* rgba, int width, int height, int firstRow, int lastRow, uint8_t* output) {
+    int blocksPerRow = (width + 3) / 4;
+    uint8_t block[64];
+
+    for (int by = firstRow; by < lastRow; by++) {
+        for (int bx = 0; bx < blocksPerRow; bx++) {
+            // Blocks hanging over the edges repeat the last row and column
+            for (int y = 0; y < 4; y++) {
+                for (int x = 0; x < 4; x++) {
+                    int sx = std::min(bx * 4 + x, width - 1);
+                    int sy = std::min(by * 4 + y, height - 1);
+                    std::memcpy(block + (y * 4 + x) * 4, rgba + (static_cast<size_t>(sy) * width + sx) * 4, 4);
+                }
+            }
+
+            uint8_t* destination = output + (static_cast<size_t>(by) * blocksPerRow + bx) * blockBytes(format);
+            switch (format) {
+            case Format::BC1:
+                encodeColor(block, destination);
+                break;
+            case Format::BC3:
+                encodeChannel(block, 3, destination);
+                encodeColor(block, destination + 8);
+                break;
+            case Format::BC5:
+                encodeChannel(block, 0, destination);
+                encodeChannel(block, 1, destination + 8);
+                break;
+            }
+        }
+    }
+}
+
+void BcEncoder::encodeColor(const uint8_t block[64], uint8_t* output) {
+    uint8_t min[4], max[4];
+    boundingBox(block, min, max);
+    for (int c = 0; c < 3; c++) {
+        inset(min[c], max[c], 4);
+    }
+
+    // max >= min on every channel so color0 >= color1, the block uses the four colors mode unless they're equal
+    uint16_t color0 = to565(max);
+    uint16_t color1 = to565(min);
+
+    uint32_t indices = 0;
+    if (color0 != color1) {
+        int16_t base[4], end[4], direction[4];
+        from565(color1, base);
+        from565(color0, end);
+        for (int c = 0; c < 4; c++) {
+            direction[c] = static_cast<int16_t>(end[c] - base[c]);
+        }
+
+        int positions[16];
+        project(block, base, direction, 3, positions);
+        // Position 0 is color1 and 3 is color0, with the interpolated colors in between
+        constexpr uint32_t TO_INDEX[4] = { 1, 3, 2, 0 };
+        for (int i = 0; i < 16; i++) {
+            indices |= TO_INDEX[positions[i]] << (2 * i);
+        }
+    }
+
+    std::memcpy(output, &color0, 2);
+    std::memcpy(output + 2, &color1, 2);
+    std::memcpy(output + 4, &indices, 4);
+}
+
+void BcEncoder::encodeChannel(const uint8_t block[64], int channel, uint8_t* output) {
+    uint8_t min[4], max[4];
+    boundingBox(block, min, max);
+    inset(min[channel], max[channel], 5);
+
+    // alpha0 > alpha1 selects the eight values mode, equal ends need no indices
+    uint8_t alpha0 = max[channel];
+    uint8_t alpha1 = min[channel];
+
+    uint64_t indices = 0;
+    if (alpha0 != alpha1) {
+        int16_t base[4] = { 0, 0, 0, 0 };
+        int16_t direction[4] = { 0, 0, 0, 0 };
+        base[channel] = alpha1;
+        direction[channel] = static_cast<int16_t>(alpha0 - alpha1);
+
+        int positions[16];
+        project(block, base, direction, 7, positions);
+        // Position 0 is alpha1 and 7 is alpha0, indices 2 to 7 go from alpha0 to alpha1
+        constexpr uint64_t TO_INDEX[8] = { 1, 7, 6, 5, 4, 3, 2, 0 };
+        for (int i = 0; i < 16; i++) {
+            indices |= TO_INDEX[positions[i]] << (3 * i);
+        }
+    }
+
+    output[0] = alpha0;
+    output[1] = alpha1;
+    std::memcpy(output + 2, &indices, 6);
+}
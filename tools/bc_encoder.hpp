@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Real-time BC1, BC3 and BC5 encoder working on RGBA8 images
+ *
+ * Endpoints are the inset bounding box of the block, texels are given the palette entry
+ * closest to their projection on the endpoint axis. The bounding boxes and projections are
+ * computed with SSE2, or AVX2 when the compiler targets it, a scalar path is kept for other CPUs.
+ */
+class BcEncoder
+{
+public:
+    enum class Format {
+        BC1,
+        BC3,
+        BC5
+    };
+
+    /**
+     * @brief Number of bytes of a 4x4 block
+     */
+    static size_t blockBytes(Format format);
+
+    /**
+     * @brief Number of bytes of an encoded level
+     */
+    static size_t levelSize(Format format, int width, int height);
+
+    /**
+     * @brief Encode a range of block rows of a level, ranges can be encoded in parallel
+     *
+     * @param rgba The whole level, tightly packed
+     * @param firstRow The first block row to encode
+     * @param lastRow One past the last block row to encode
+     * @param output The whole encoded level, of @ref levelSize bytes
+     */
+    static void encode(Format format, const uint8_t *rgba, int width, int height, int firstRow, int lastRow, uint8_t *output);
+
+private:
+    static void encodeColor(const uint8_t block[64], uint8_t *output);
+    static void encodeChannel(const uint8_t block[64], int channel, uint8_t *output);
+};
@@ -0,0 +1,322 @@
+/**
+ * Offline cooker turning the images loaded by Texture::getTextureFromFile into KTX2 files of block compressed mip chains.
+ *
+ * Each image is written under cache/cooked with the .ktx2 extension, see cookedPath, where the runtime picks it up instead of the source.
+ * The cooker must run from the directory the engine runs from.
+ * Images whose cooked file is newer than the source and was cooked by this version with the same options are skipped,
+ * so the cooker can run on every build. The options are recorded in the key/value data of the file, see CookedTexture.
+ *
+ * Usage: texture-cook [-f auto|bc1|bc3|bc5] [-j threads] [--force] [--srgb|--linear] images... [--srgb|--linear] images...
+ * --srgb filters the mips of the images after it in linear space, like the engine does for color maps,
+ * --linear filters the following data maps as they are, the default. One run can then cook both kinds.
+ */
+
+#include "bc_encoder.hpp"
+
+#include "headers/cooked_path.hpp"
+#include "headers/cooked_texture.hpp"
+#include "headers/logger.hpp"
+#include "headers/mip_generator.hpp"
+#include "headers/thread_pool.hpp"
+
+#include <stb/stb_image.h>
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace {
+    constexpr const char* USAGE = "Usage: texture-cook [-f auto|bc1|bc3|bc5] [-j threads] [--force] [--srgb|--linear] images...";
+
+    // Block rows encoded by each job, small enough to spread a single large image over every core
+    constexpr int ROWS_PER_JOB = 16;
+
+    struct Level {
+        int width;
+        int height;
+        std::vector<uint8_t> rgba;
+        std::vector<uint8_t> encoded;
+    };
+
+    struct Image {
+        std::string source;
+        std::string destination;
+        BcEncoder::Format format;
+        std::vector<Level> levels;
+        // Recorded in the file, see CookedTexture
+        std::string formatName;
+        std::string mips;
+    };
+
+    /**
+     * @brief Decode the source and build its whole mip chain
+     */
+    bool prepare(Image& image, std::optional<BcEncoder::Format> format, const MipGenerator::Options& mips) {
+        int width, height, channels;
+        uint8_t* data = stbi_load(image.source.c_str(), &width, &height, &channels, 4);
+        if (data == nullptr) {
+            logger.error("Failed to load texture: " + image.source + " (" + stbi_failure_reason() + ")");
+            return false;
+        }
+
+        TextureImage decoded;
+        decoded.width = width;
+        decoded.height = height;
+        decoded.channels = 4;
+        decoded.pixels.assign(data, data + static_cast<size_t>(width) * height * 4);
+        decoded.levels = { { 0, decoded.pixels.size(), width, height } };
+        stbi_image_free(data);
+
+        if (format) {
+            image.format = *format;
+        } else {
+            bool opaque = true;
+            for (size_t i = 3; i < decoded.pixels.size() && opaque; i += 4) {
+                opaque = decoded.pixels[i] == 255;
+            }
+            image.format = opaque ? BcEncoder::Format::BC1 : BcEncoder::Format::BC3;
+        }
+
+        MipGenerator::generate(decoded, mips);
+        for (const TextureLevel& level : decoded.levels) {
+            const uint8_t* pixels = decoded.pixels.data() + level.offset;
+            image.levels.push_back({ level.width, level.height, std::vector<uint8_t>(pixels, pixels + level.size),
+                                     std::vector<uint8_t>(BcEncoder::levelSize(image.format, level.width, level.height)) });
+        }
+        return true;
+    }
+
+    template <typename T>
+    void append(std::vector<uint8_t>& bytes, const T& value) {
+        const uint8_t* data = reinterpret_cast<const uint8_t*>(&value);
+        bytes.insert(bytes.end(), data, data + sizeof(T));
+    }
+
+    void pad(std::vector<uint8_t>& bytes, size_t alignment) {
+        bytes.resize((bytes.size() + alignment - 1) / alignment * alignment, 0);
+    }
+
+    /**
+     * @brief Append a key/value entry, string values keep their null terminator
+     */
+    void appendValue(std::vector<uint8_t>& bytes, const std::string& key, const std::string& value) {
+        append(bytes, uint32_t(key.size() + 1 + value.size() + 1));
+        bytes.insert(bytes.end(), key.begin(), key.end());
+        bytes.push_back(0);
+        bytes.insert(bytes.end(), value.begin(), value.end());
+        bytes.push_back(0);
+        pad(bytes, 4);
+    }
+
+    /**
+     * @brief Write the encoded levels in a KTX2 file, the levels are stored smallest first as the format requires
+     */
+    bool write(const Image& image) {
+        uint32_t vkFormat = 0, colorModel = 0;
+        switch (image.format) {
+        case BcEncoder::Format::BC1: vkFormat = 131; colorModel = 128; break;  // VK_FORMAT_BC1_RGB_UNORM_BLOCK, KHR_DF_MODEL_BC1A
+        case BcEncoder::Format::BC3: vkFormat = 137; colorModel = 130; break;  // VK_FORMAT_BC3_UNORM_BLOCK, KHR_DF_MODEL_BC3
+        case BcEncoder::Format::BC5: vkFormat = 141; colorModel = 132; break;  // VK_FORMAT_BC5_UNORM_BLOCK, KHR_DF_MODEL_BC5
+        }
+        uint32_t blockBytes = static_cast<uint32_t>(BcEncoder::blockBytes(image.format));
+        uint32_t levelCount = static_cast<uint32_t>(image.levels.size());
+
+        // Basic data format descriptor, BC3 and BC5 blocks are made of two 64 bits samples
+        struct Sample {
+            uint32_t channel;
+            uint32_t offset;
+        };
+        std::vector<Sample> samples;
+        switch (image.format) {
+        case BcEncoder::Format::BC1: samples = { { 0, 0 } }; break;
+        case BcEncoder::Format::BC3: samples = { { 15, 0 }, { 0, 64 } }; break;
+        case BcEncoder::Format::BC5: samples = { { 0, 0 }, { 1, 64 } }; break;
+        }
+        std::vector<uint8_t> dfd;
+        uint32_t blockSize = 24 + 16 * static_cast<uint32_t>(samples.size());
+        append(dfd, 4 + blockSize);
+        append(dfd, uint32_t(0));                    // vendor and descriptor type
+        append(dfd, uint32_t(2 | blockSize << 16));  // version and block size
+        append(dfd, uint32_t(colorModel | 1 << 8 | 1 << 16));  // model, BT.709 primaries, linear transfer, straight alpha
+        append(dfd, uint32_t(3 | 3 << 8));           // 4x4 texel blocks
+        append(dfd, blockBytes);                     // bytes in plane 0
+        append(dfd, uint32_t(0));
+        for (const Sample& sample : samples) {
+            append(dfd, uint32_t(sample.offset | 63 << 16 | sample.channel << 24));
+            append(dfd, uint32_t(0));
+            append(dfd, uint32_t(0));
+            append(dfd, UINT32_MAX);
+        }
+
+        std::vector<uint8_t> kvd;
+        appendValue(kvd, CookedTexture::FORMAT_KEY, image.formatName);
+        appendValue(kvd, CookedTexture::MIPS_KEY, image.mips);
+        appendValue(kvd, CookedTexture::VERSION_KEY, CookedTexture::VERSION);
+        appendValue(kvd, "KTXorientation", "rd");
+
+        uint32_t dfdOffset = 80 + 24 * levelCount;
+        uint32_t kvdOffset = dfdOffset + static_cast<uint32_t>(dfd.size());
+
+        std::vector<uint8_t> header;
+        const uint8_t identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+        header.insert(header.end(), identifier, identifier + 12);
+        for (uint32_t value : { vkFormat, 1u, uint32_t(image.levels[0].width), uint32_t(image.levels[0].height), 0u, 0u, 1u, levelCount, 0u,
+                                dfdOffset, uint32_t(dfd.size()), kvdOffset, uint32_t(kvd.size()) }) {
+            append(header, value);
+        }
+        append(header, uint64_t(0));
+        append(header, uint64_t(0));
+
+        // Levels start on a multiple of the block size, smallest first
+        std::vector<uint64_t> offsets(levelCount);
+        uint64_t end = kvdOffset + kvd.size();
+        for (uint32_t i = levelCount; i-- > 0;) {
+            end = (end + blockBytes - 1) / blockBytes * blockBytes;
+            offsets[i] = end;
+            end += image.levels[i].encoded.size();
+        }
+        for (uint32_t i = 0; i < levelCount; i++) {
+            append(header, offsets[i]);
+            append(header, uint64_t(image.levels[i].encoded.size()));
+            append(header, uint64_t(image.levels[i].encoded.size()));
+        }
+
+        std::vector<uint8_t> file = std::move(header);
+        file.insert(file.end(), dfd.begin(), dfd.end());
+        file.insert(file.end(), kvd.begin(), kvd.end());
+        for (uint32_t i = levelCount; i-- > 0;) {
+            file.resize(offsets[i], 0);
+            file.insert(file.end(), image.levels[i].encoded.begin(), image.levels[i].encoded.end());
+        }
+
+        // Written aside then renamed, the runtime never sees a partial file
+        std::string temporary = image.destination + ".tmp";
+        std::error_code error;
+        std::filesystem::create_directories(std::filesystem::path(image.destination).parent_path(), error);
+        {
+            std::ofstream stream(temporary, std::ios::binary | std::ios::trunc);
+            if (!stream.write(reinterpret_cast<const char*>(file.data()), file.size())) {
+                logger.error("Failed to write cooked texture: " + image.destination);
+                return false;
+            }
+        }
+        std::filesystem::rename(temporary, image.destination, error);
+        if (error) {
+            logger.error("Failed to write cooked texture: " + image.destination + " (" + error.message() + ")");
+            return false;
+        }
+        return true;
+    }
+}
+
+int main(int argc, char** argv) {
+    std::optional<BcEncoder::Format> format;
+    std::string formatName = "auto";
+    unsigned int threads = std::thread::hardware_concurrency();
+    bool force = false;
+    MipGenerator::Options mips;
+    // Each image is cooked with the mip options given before it
+    std::vector<std::pair<std::string, MipGenerator::Options>> sources;
+
+    for (int i = 1; i < argc; i++) {
+        std::string argument = argv[i];
+        if (argument == "-f" && i + 1 < argc) {
+            std::string name = argv[++i];
+            if (name == "bc1") {
+                format = BcEncoder::Format::BC1;
+            } else if (name == "bc3") {
+                format = BcEncoder::Format::BC3;
+            } else if (name == "bc5") {
+                format = BcEncoder::Format::BC5;
+            } else if (name != "auto") {
+                logger.error("Unknown format: " + name);
+                return 1;
+            }
+            formatName = name;
+        } else if (argument == "-j" && i + 1 < argc) {
+            const char* value = argv[++i];
+            const char* end = value + std::strlen(value);
+            auto [last, error] = std::from_chars(value, end, threads);
+            if (error != std::errc() || last != end) {
+                logger.error("Invalid thread count: " + std::string(value));
+                logger.log(USAGE);
+                return 1;
+            }
+        } else if (argument == "--srgb") {
+            mips.srgb = true;
+        } else if (argument == "--linear") {
+            mips.srgb = false;
+        } else if (argument == "--force") {
+            force = true;
+        } else {
+            sources.push_back({ argument, mips });
+        }
+    }
+
+    if (sources.empty()) {
+        logger.log(USAGE);
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<Image> images;
+    std::vector<MipGenerator::Options> imageMips;
+    for (const auto& [source, sourceMips] : sources) {
+        std::string destination = cookedPath(source, ".ktx2");
+        std::string description = MipGenerator::describe(sourceMips);
+        if (force || !CookedTexture::isUpToDate(source, destination, description, formatName)) {
+            images.push_back({ source, destination, BcEncoder::Format::BC1, {}, formatName, description });
+            imageMips.push_back(sourceMips);
+        }
+    }
+
+    ThreadPool pool(threads);
+
+    // Decode and build the mip chains, one image per job
+    std::vector<std::future<bool>> prepared;
+    for (size_t i = 0; i < images.size(); i++) {
+        prepared.push_back(pool.submit([&image = images[i], format, mips = imageMips[i]]() { return prepare(image, format, mips); }));
+    }
+
+    // Then encode bands of block rows, every core stays busy even with a single large image
+    std::vector<std::future<void>> encoded;
+    std::vector<bool> valid;
+    for (size_t i = 0; i < images.size(); i++) {
+        valid.push_back(prepared[i].get());
+        if (!valid.back()) {
+            continue;
+        }
+        for (Level& level : images[i].levels) {
+            int rows = (level.height + 3) / 4;
+            for (int first = 0; first < rows; first += ROWS_PER_JOB) {
+                BcEncoder::Format imageFormat = images[i].format;
+                encoded.push_back(pool.submit([&level, imageFormat, first, rows]() {
+                    BcEncoder::encode(imageFormat, level.rgba.data(), level.width, level.height, first, std::min(first + ROWS_PER_JOB, rows),
+                                      level.encoded.data());
+                }));
+            }
+        }
+    }
+    for (std::future<void>& job : encoded) {
+        job.get();
+    }
+
+    size_t cooked = 0;
+    for (size_t i = 0; i < images.size(); i++) {
+        if (valid[i] && write(images[i])) {
+            cooked++;
+        }
+    }
+
+    double time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    logger.log("Cooked " + std::to_string(cooked) + " textures, " + std::to_string(sources.size() - images.size()) + " up to date, in "
+               + std::to_string(time) + " ms on " + std::to_string(pool.size()) + " threads");
+    return cooked == images.size() ? 0 : 1;
+}